@@ -0,0 +1,130 @@
+#pragma once
+
+#include "util.h"
+
+// A Table that allocates memory in square chunks, only when a value in the chunk is written.
+// Unwritten cells read as the default value, so large, mostly uniform maps stay cheap.
+template <class T>
+class ChunkedTable {
+  public:
+  ChunkedTable(Rectangle bounds, const T& defaultValue = T()) : bounds(bounds),
+      numChunksY((bounds.height() + chunkSize - 1) / chunkSize),
+      chunks(((bounds.width() + chunkSize - 1) / chunkSize) * numChunksY), defaultValue(defaultValue) {
+  }
+
+  ChunkedTable(ChunkedTable&&) = default;
+  ChunkedTable& operator = (ChunkedTable&&) = default;
+
+  ChunkedTable(const ChunkedTable& other) : bounds(other.bounds), numChunksY(other.numChunksY),
+      chunks(other.chunks.size()), defaultValue(other.defaultValue) {
+    copyChunks(other);
+  }
+
+  ChunkedTable& operator = (const ChunkedTable& other) {
+    bounds = other.bounds;
+    numChunksY = other.numChunksY;
+    defaultValue = other.defaultValue;
+    chunks.clear();
+    chunks.resize(other.chunks.size());
+    copyChunks(other);
+    return *this;
+  }
+
+  const Rectangle& getBounds() const {
+    return bounds;
+  }
+
+  const T& operator[](Vec2 v) const {
+    auto& chunk = chunks[getChunkIndex(v)];
+    if (!chunk)
+      return defaultValue;
+    return chunk[getIndexInChunk(v)];
+  }
+
+  T& getWritable(Vec2 v) {
+    auto& chunk = chunks[getChunkIndex(v)];
+    if (!chunk)
+      chunk = allocateChunk();
+    return chunk[getIndexInChunk(v)];
+  }
+
+  int getNumAllocatedChunks() const {
+    int ret = 0;
+    for (auto& chunk : chunks)
+      if (chunk)
+        ++ret;
+    return ret;
+  }
+
+  long long getMemoryUsage() const {
+    return (long long) getNumAllocatedChunks() * getChunkArea() * sizeof(T) + chunks.capacity() * sizeof(chunks[0]);
+  }
+
+  static constexpr int getChunkArea() {
+    return chunkSize * chunkSize;
+  }
+
+  template <class Archive>
+  void save(Archive& ar, const unsigned int version) const {
+    ar << bounds << defaultValue;
+    for (auto& chunk : chunks) {
+      bool allocated = !!chunk;
+      ar << allocated;
+      if (allocated)
+        saveArray(ar, chunk.get(), getChunkArea());
+    }
+  }
+
+  template <class Archive>
+  void load(Archive& ar, const unsigned int version) {
+    ar >> bounds >> defaultValue;
+    numChunksY = (bounds.height() + chunkSize - 1) / chunkSize;
+    chunks.clear();
+    chunks.resize(((bounds.width() + chunkSize - 1) / chunkSize) * numChunksY);
+    for (auto& chunk : chunks) {
+      bool allocated;
+      ar >> allocated;
+      if (allocated) {
+        chunk.reset(new T[getChunkArea()]);
+        loadArray(ar, chunk.get(), getChunkArea());
+      }
+    }
+  }
+
+  SERIALIZATION_CONSTRUCTOR(ChunkedTable);
+
+  private:
+  static constexpr int chunkBits = 5;
+  static constexpr int chunkSize = 1 << chunkBits;
+
+  int getChunkIndex(Vec2 v) const {
+#ifndef RELEASE
+    CHECK(v.inRectangle(bounds)) << "ChunkedTable index out of bounds " << bounds << " " << v;
+#endif
+    return ((v.x - bounds.left()) >> chunkBits) * numChunksY + ((v.y - bounds.top()) >> chunkBits);
+  }
+
+  int getIndexInChunk(Vec2 v) const {
+    return (((v.x - bounds.left()) & (chunkSize - 1)) << chunkBits) + ((v.y - bounds.top()) & (chunkSize - 1));
+  }
+
+  unique_ptr<T[]> allocateChunk() const {
+    unique_ptr<T[]> ret(new T[getChunkArea()]);
+    for (int i : Range(getChunkArea()))
+      ret[i] = defaultValue;
+    return ret;
+  }
+
+  void copyChunks(const ChunkedTable& other) {
+    for (int i : All(chunks))
+      if (auto& chunk = other.chunks[i]) {
+        chunks[i].reset(new T[getChunkArea()]);
+        std::copy(chunk.get(), chunk.get() + getChunkArea(), chunks[i].get());
+      }
+  }
+
+  Rectangle bounds;
+  int numChunksY = 0;
+  vector<unique_ptr<T[]>> chunks;
+  T defaultValue;
+};
@@ -56,7 +56,7 @@ int Intervalometer::getCount(milliseconds mill) {
 }
 
 
-ScopeTimer::ScopeTimer(const char* msg) : message(msg) {
+ScopeTimer::ScopeTimer(const char* msg) : message(msg), profilerScope(msg) {
 }
 
 ScopeTimer::~ScopeTimer() {
@@ -2,6 +2,7 @@
 
 #include "stdafx.h"
 #include "extern/optional.h"
+#include "profiler.h"
 
 class Clock {
   public:
@@ -28,6 +29,7 @@ class ScopeTimer {
   private:
   const char* message;
   Clock clock;
+  Profiler::Scope profilerScope;
 };
 
 class Intervalometer {
@@ -55,6 +55,7 @@
 #include "game_config.h"
 #include "conquer_condition.h"
 #include "game_event.h"
+#include "memory_report.h"
 
 template <class Archive>
 void Collective::serialize(Archive& ar, const unsigned int version) {
@@ -1399,6 +1400,15 @@ const TaskMap& Collective::getTaskMap() const {
   return *taskMap;
 }
 
+void Collective::addMemoryUsage(MemoryReport& report) const {
+  auto& collectiveReport = report.addChild("Collective " + (name ? name->full : "without name"_s));
+  collectiveReport.add("tasks", taskMap->getMemoryUsage());
+  collectiveReport.add("known tiles", knownTiles->getMemoryUsage());
+  collectiveReport.add("territory", MemoryReport::getSize(territory->getAllAsSet()) +
+      MemoryReport::getSize(territory->getAll()));
+  collectiveReport.add("delayed positions", MemoryReport::getSize(delayedPos));
+}
+
 TaskMap& Collective::getTaskMap() {
   return *taskMap;
 }
@@ -48,6 +48,7 @@ struct ItemFetchInfo;
 class CollectiveWarnings;
 class Immigration;
 class Quarters;
+class MemoryReport;
 class PositionMatching;
 
 class Collective : public TaskCallback, public UniqueEntity<Collective>, public EventListener<Collective> {
@@ -189,6 +190,7 @@ class Collective : public TaskCallback, public UniqueEntity<Collective>, public
   const heap_optional<CollectiveName>& getName() const;
   const TaskMap& getTaskMap() const;
   TaskMap& getTaskMap();
+  void addMemoryUsage(MemoryReport&) const;
   void updateResourceProduction();
   bool isItemMarked(WConstItem) const;
   int getNumItems(ItemIndex, bool includeMinions = true) const;
@@ -347,13 +347,13 @@ static EnumMap<WorkshopType, WorkshopInfo> workshops([](WorkshopType type)->Work
   }});
 
 optional<WorkshopType> CollectiveConfig::getWorkshopType(FurnitureType furniture) {
-  static optional<EnumMap<FurnitureType, optional<WorkshopType>>> map;
-  if (!map) {
-    map.emplace();
+  static const EnumMap<FurnitureType, optional<WorkshopType>> map = [] {
+    EnumMap<FurnitureType, optional<WorkshopType>> ret;
     for (auto type : ENUM_ALL(WorkshopType))
-      (*map)[workshops[type].furniture] = type;
-  }
-  return (*map)[furniture];
+      ret[workshops[type].furniture] = type;
+    return ret;
+  }();
+  return map[furniture];
 }
 
 map<CollectiveResourceId, int> CollectiveConfig::getStartingResource() const {
@@ -915,6 +915,8 @@ void Creature::setPosition(Position pos) {
   }
   if (shortestPath && shortestPath->getLevel() != pos.getLevel())
     shortestPath = none;
+  precomputedPath = none;
+  keepCachedPath = false;
   position = pos;
   if (nextPosIntent && !position.isSameLevel(*nextPosIntent))
     nextPosIntent = none;
@@ -1722,6 +1724,34 @@ bool Creature::canNavigateTo(Position pos) const {
   return pos.canNavigateTo(position, getMovementType());
 }
 
+// A path is kept between turns and computed again once in a while, or when the target moved
+bool Creature::needsNewPath(const heap_optional<LevelShortestPath>& path, Position target, bool away) const {
+  return !path || Random.roll(10) || path->isReversed() != away ||
+      path->getTarget().dist8(target) > position.dist8(target) / 10;
+}
+
+bool Creature::shouldPrecomputePath() {
+  // Short paths are cheap enough to compute when they're needed
+  if (isPlayer() || !shortestPath || shortestPath->getLevel() != position.getLevel() ||
+      shortestPath->getTarget().dist8(position) < 10)
+    return false;
+  if (needsNewPath(shortestPath, shortestPath->getTarget(), shortestPath->isReversed()))
+    return true;
+  // The decision is made, so moveTowards doesn't roll again for the same target
+  keepCachedPath = true;
+  return false;
+}
+
+void Creature::precomputePath() {
+  PROFILE;
+  precomputedPath = LevelShortestPath(this, shortestPath->getTarget(), position, shortestPath->isReversed() ? -1.5 : 0);
+}
+
+void Creature::discardPrecomputedPath() {
+  precomputedPath = none;
+  keepCachedPath = false;
+}
+
 CreatureAction Creature::moveTowards(Position pos, bool away, NavigationFlags flags) {
   PROFILE;
   CHECK(pos.isSameLevel(position));
@@ -1730,11 +1760,18 @@ CreatureAction Creature::moveTowards(Position pos, bool away, NavigationFlags fl
   if (!away && !canNavigateToOrNeighbor(pos))
     return CreatureAction();
   auto currentPath = shortestPath;
+  // A path computed at the start of this turn is as fresh as a new one
+  bool precomputed = precomputedPath && precomputedPath->getTarget() == pos &&
+      precomputedPath->isReversed() == away && precomputedPath->isReachable(position);
+  if (precomputed)
+    currentPath = *precomputedPath;
+  bool keepCached = keepCachedPath && currentPath && currentPath->getTarget() == pos &&
+      currentPath->isReversed() == away;
+  discardPrecomputedPath();
   for (int i : Range(2)) {
-    bool wasNew = false;
+    bool wasNew = precomputed && i == 0;
     INFO << identify() << (away ? " retreating " : " navigating ") << position.getCoord() << " to " << pos.getCoord();
-    if (!currentPath || Random.roll(10) || currentPath->isReversed() != away ||
-        currentPath->getTarget().dist8(pos) > getPosition().dist8(pos) / 10) {
+    if (!wasNew && !(keepCached && i == 0) && needsNewPath(currentPath, pos, away)) {
       INFO << "Calculating new path";
       currentPath = LevelShortestPath(this, pos, position, away ? -1.5 : 0);
       wasNew = true;
@@ -56,7 +56,7 @@ struct AdjectiveInfo;
 struct MovementInfo;
 struct NavigationFlags;
 
-class Creature : public Renderable, public UniqueEntity<Creature>, public OwnedObject<Creature> {
+class Creature : public Renderable, public UniqueEntity<Creature>, public OwnedObject<Creature>, public PoolAllocated {
   public:
   Creature(TribeId, CreatureAttributes);
   Creature(const ViewObject&, TribeId, CreatureAttributes);
@@ -207,6 +207,13 @@ class Creature : public Renderable, public UniqueEntity<Creature>, public OwnedO
 
   bool atTarget() const;
 
+  /** Used by Model to compute the paths of creatures following long paths in parallel, at the start of a turn.
+      shouldPrecomputePath() decides on the main thread what moveTowards() would decide for the same target.
+      precomputePath() only reads the level and may be called from any thread.*/
+  bool shouldPrecomputePath();
+  void precomputePath();
+  void discardPrecomputedPath();
+
   enum class DropType { NOTHING, ONLY_INVENTORY, EVERYTHING };
   void dieWithAttacker(WCreature attacker, DropType = DropType::EVERYTHING);
   void dieWithLastAttacker(DropType = DropType::EVERYTHING);
@@ -294,6 +301,9 @@ class Creature : public Renderable, public UniqueEntity<Creature>, public OwnedO
   Position SERIAL(position);
   HeapAllocated<Equipment> SERIAL(equipment);
   heap_optional<LevelShortestPath> SERIAL(shortestPath);
+  heap_optional<LevelShortestPath> precomputedPath;
+  bool keepCachedPath = false;
+  bool needsNewPath(const heap_optional<LevelShortestPath>&, Position target, bool away) const;
   EntitySet<Creature> SERIAL(knownHiding);
   TribeId SERIAL(tribe);
   double SERIAL(morale) = 0;
@@ -531,7 +531,7 @@ PCreature CreatureFactory::get(CreatureAttributes attr, TribeId tribe, const Con
 }
 
 static ViewId getSpecialViewId(bool humanoid, bool large, bool body, bool wings) {
-  static vector<ViewId> specialViewIds {
+  static const vector<ViewId> specialViewIds {
     ViewId::SPECIAL_BLBN,
     ViewId::SPECIAL_BLBW,
     ViewId::SPECIAL_BLGN,
@@ -553,7 +553,7 @@ static ViewId getSpecialViewId(bool humanoid, bool large, bool body, bool wings)
 }
 
 static string getSpeciesName(bool humanoid, bool large, bool living, bool wings) {
-  static vector<string> names {
+  static const vector<string> names {
     "devitablex",
     "owlbeast",
     "hellar dra",
@@ -575,7 +575,7 @@ static string getSpeciesName(bool humanoid, bool large, bool living, bool wings)
 }
 
 static optional<ItemType> getSpecialBeastAttack(bool large, bool living, bool wings) {
-  static vector<optional<ItemType>> attacks {
+  static const vector<optional<ItemType>> attacks {
     ItemType(ItemType::fangs(7)),
     ItemType(ItemType::fangs(7, Effect::Fire{})),
     ItemType(ItemType::fangs(7, Effect::Fire{})),
@@ -589,7 +589,7 @@ static optional<ItemType> getSpecialBeastAttack(bool large, bool living, bool wi
 }
 
 static EnumMap<BodyPart, int> getSpecialBeastBody(bool large, bool living, bool wings) {
-  static vector<EnumMap<BodyPart, int>> parts {
+  static const vector<EnumMap<BodyPart, int>> parts {
     {
       { BodyPart::LEG, 2}},
     {
@@ -82,7 +82,8 @@ CreatureGroup::CreatureGroup(const CreatureGroup&) = default;
 
 CreatureGroup& CreatureGroup::operator =(const CreatureGroup&) = default;
 
-static optional<pair<CreatureGroup, CreatureGroup>> splashFactories;
+// Sites are generated on several threads, and each thread picks its own splash heroes
+static thread_local optional<pair<CreatureGroup, CreatureGroup>> splashFactories;
 
 void CreatureGroup::initSplash(TribeId tribe) {
   splashFactories = Random.choose(
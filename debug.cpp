@@ -45,7 +45,7 @@ void DebugLog::addOutput(DebugOutput o) {
 }
 
 DebugLog::Logger DebugLog::get() {
-  return Logger(outputs);
+  return Logger(outputs, mutex);
 }
 
 DebugLog InfoLog;
@@ -75,9 +75,11 @@ class DebugLog {
   public:
   void addOutput(DebugOutput);
 
+  // Holds the log's lock until the line is finished, so that lines logged from different threads don't mix
   class Logger {
     public:
-    Logger(std::vector<DebugOutput>& s) : outputs(s) {}
+    Logger(std::vector<DebugOutput>& s, std::recursive_mutex& mutex) : outputs(s), lock(mutex) {}
+    Logger(Logger&&) = default;
 
     template <typename T>
     Logger& operator << (const T& t) {
@@ -86,18 +88,22 @@ class DebugLog {
       return *this;
     }
     ~Logger() {
+      if (!lock.owns_lock())
+        return;
       for (int i = outputs.size() - 1; i >= 0; --i)
         outputs[i].onLineEnd();
     }
 
     private:
     std::vector<DebugOutput>& outputs;
+    std::unique_lock<std::recursive_mutex> lock;
   };
 
   Logger get();
 
   private:
   std::vector<DebugOutput> outputs;
+  std::recursive_mutex mutex;
 };
 
 extern DebugLog InfoLog;
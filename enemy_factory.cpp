@@ -92,7 +92,7 @@ struct VaultInfo {
 };
 }
 
-static EnumMap<TribeAlignment, vector<VaultInfo>> friendlyVaults {
+static const EnumMap<TribeAlignment, vector<VaultInfo>> friendlyVaults {
   {TribeAlignment::EVIL, {
       {"ORC", 3, 5},
       {"OGRE", 2, 4},
@@ -104,7 +104,7 @@ static EnumMap<TribeAlignment, vector<VaultInfo>> friendlyVaults {
   }},
 };
 
-static vector<VaultInfo> hostileVaults {
+static const vector<VaultInfo> hostileVaults {
   {"SPIDER", 3, 8},
   {"SNAKE", 3, 8},
   {"BAT", 3, 8},
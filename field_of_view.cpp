@@ -20,6 +20,7 @@
 #include "square_array.h"
 #include "level.h"
 #include "position.h"
+#include "memory_report.h"
 
 template <class Archive>
 void FieldOfView::serialize(Archive& ar, const unsigned int) {
@@ -92,6 +93,18 @@ const vector<Vec2>& FieldOfView::Visibility::getVisibleTiles() const {
   return visibleTiles;
 }
 
+long long FieldOfView::Visibility::getMemoryUsage() const {
+  return sizeof(Visibility) + MemoryReport::getSize(visibleTiles);
+}
+
+long long FieldOfView::getMemoryUsage() const {
+  long long ret = MemoryReport::getSize(visibility) + MemoryReport::getSize(blocking);
+  for (Vec2 v : visibility.getBounds())
+    if (visibility[v])
+      ret += visibility[v]->getMemoryUsage();
+  return ret;
+}
+
 const vector<Vec2>& FieldOfView::getVisibleTiles(Vec2 from) {
   if (!visibility[from]) {
     visibility[from].reset(new Visibility(level->getBounds(), blocking, from.x, from.y));
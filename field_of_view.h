@@ -26,6 +26,7 @@ class FieldOfView {
   bool canSee(Vec2 from, Vec2 to);
   const vector<Vec2>& getVisibleTiles(Vec2 from);
   void squareChanged(Vec2 pos);
+  long long getMemoryUsage() const;
 
   SERIALIZATION_DECL(FieldOfView)
 
@@ -39,6 +40,7 @@ class FieldOfView {
 
     bool checkVisible(int x,int y) const;
     const vector<Vec2>& getVisibleTiles() const;
+    long long getMemoryUsage() const;
 
     Visibility(Rectangle bounds, const Table<bool>& blocking, int x, int y);
 
@@ -20,7 +20,7 @@ class FurnitureDroppedItems;
 class ViewObject;
 class MovementSet;
 
-class Furniture : public OwnedObject<Furniture> {
+class Furniture : public OwnedObject<Furniture>, public PoolAllocated {
   public:
   static const string& getName(FurnitureType, int count = 1);
   static FurnitureLayer getLayer(FurnitureType);
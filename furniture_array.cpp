@@ -6,7 +6,7 @@ SERIALIZATION_CONSTRUCTOR_IMPL(FurnitureArray)
 
 FurnitureArray::FurnitureArray(Rectangle bounds) :
   built([&](FurnitureLayer) { return Array(bounds); }),
-construction([&](FurnitureLayer) { return Table<optional<Construction>>(bounds); }) {
+construction([&](FurnitureLayer) { return ChunkedTable<optional<Construction>>(bounds); }) {
 }
 
 const FurnitureArray::Array& FurnitureArray::getBuilt(FurnitureLayer layer) const {
@@ -22,5 +22,17 @@ const optional<FurnitureArray::Construction>& FurnitureArray::getConstruction(Ve
 }
 
 optional<FurnitureArray::Construction>& FurnitureArray::getConstruction(Vec2 pos, FurnitureLayer layer) {
-  return construction[layer][pos];
+  return construction[layer].getWritable(pos);
+}
+
+void FurnitureArray::clearConstruction(Vec2 pos, FurnitureLayer layer) {
+  if (construction[layer][pos])
+    construction[layer].getWritable(pos) = none;
+}
+
+long long FurnitureArray::getMemoryUsage() const {
+  long long ret = 0;
+  for (auto layer : ENUM_ALL(FurnitureLayer))
+    ret += built[layer].getMemoryUsage() + construction[layer].getMemoryUsage();
+  return ret;
 }
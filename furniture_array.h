@@ -1,6 +1,7 @@
 #pragma once
 
 #include "read_write_array.h"
+#include "chunked_table.h"
 #include "furniture_factory.h"
 #include "furniture.h"
 #include "furniture_layer.h"
@@ -28,10 +29,12 @@ class FurnitureArray {
 
   const optional<Construction>& getConstruction(Vec2, FurnitureLayer) const;
   optional<Construction>& getConstruction(Vec2, FurnitureLayer);
+  void clearConstruction(Vec2, FurnitureLayer);
+  long long getMemoryUsage() const;
 
   SERIALIZATION_DECL(FurnitureArray)
 
   private:
   EnumMap<FurnitureLayer, Array> SERIAL(built);
-  EnumMap<FurnitureLayer, Table<optional<Construction>>> SERIAL(construction);
+  EnumMap<FurnitureLayer, ChunkedTable<optional<Construction>>> SERIAL(construction);
 };
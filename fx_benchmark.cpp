@@ -0,0 +1,76 @@
+#include "fx_benchmark.h"
+
+#include "fx_manager.h"
+#include "fx_particle_system.h"
+#include "fx_defs.h"
+#include "clock.h"
+
+namespace fx {
+
+static constexpr int numHeaviest = 5;
+static constexpr int numInstances = 64;
+static constexpr float frameTime = 1.0f / 60.0f;
+
+static vector<FXName> getHeaviestEffects(FXManager& manager) {
+  vector<pair<int, FXName>> counts;
+  for (auto name : ENUM_ALL(FXName)) {
+    if (!manager[name])
+      continue;
+    auto id = manager.addSystem(name, {});
+    int maxParticles = 0;
+    for (int frame = 0; frame < 180 && manager.alive(id); frame++) {
+      manager.simulateStable(frameTime);
+      maxParticles = max(maxParticles, manager.get(id).numActiveParticles());
+    }
+    manager.kill(id, true);
+    counts.emplace_back(maxParticles, name);
+  }
+  std::sort(counts.begin(), counts.end(), [](const auto& a, const auto& b) { return a.first > b.first; });
+  vector<FXName> ret;
+  for (int n = 0; n < min<int>(numHeaviest, counts.size()); n++)
+    ret.push_back(counts[n].second);
+  return ret;
+}
+
+void runBenchmark(int numFrames, int numThreads) {
+  FXManager manager;
+  manager.setNumThreads(numThreads);
+  std::cout << "Simulation threads: " << numThreads << std::endl;
+  vector<DrawParticle> quads;
+  for (auto name : getHeaviestEffects(manager)) {
+    auto getConfig = [](int index) { return InitConfig(FVec2(index * 24, 0)); };
+    vector<ParticleSystemId> ids;
+    for (int n = 0; n < numInstances; n++)
+      ids.push_back(manager.addSystem(name, getConfig(n)));
+    long long simulateTime = 0;
+    long long drawTime = 0;
+    long long numParticles = 0;
+    for (int frame = 0; frame < numFrames; frame++) {
+      // Non-looped effects are restarted, so that the load stays the same
+      for (int n = 0; n < numInstances; n++)
+        if (manager.dead(ids[n]))
+          ids[n] = manager.addSystem(name, getConfig(n));
+      auto start = Clock::getRealMicros();
+      manager.simulateStable(frameTime);
+      auto middle = Clock::getRealMicros();
+      quads.clear();
+      for (auto& id : ids)
+        if (manager.alive(id)) {
+          auto& system = manager.get(id);
+          numParticles += system.numActiveParticles();
+          for (int ssid = 0; ssid < (int)system.subSystems.size(); ssid++)
+            manager.genQuads(quads, id.getIndex(), ssid);
+        }
+      auto end = Clock::getRealMicros();
+      simulateTime += (middle - start).count();
+      drawTime += (end - middle).count();
+    }
+    for (auto id : ids)
+      manager.kill(id, true);
+    std::cout << ENUM_STRING(name) << ": " << numInstances << " instances, "
+        << numParticles / max(1, numFrames) << " particles per frame, simulation "
+        << simulateTime / max(1, numFrames) << "us per frame, quads "
+        << drawTime / max(1, numFrames) << "us per frame" << std::endl;
+  }
+}
+}
@@ -0,0 +1,8 @@
+#pragma once
+
+namespace fx {
+
+// Finds the effects with the most particles and measures how long it takes to simulate
+// and generate quads for many instances of each of them. Doesn't need a renderer.
+void runBenchmark(int numFrames, int numThreads);
+}
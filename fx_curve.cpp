@@ -98,6 +98,27 @@ template <class T> T Curve<T>::sample(float position) const {
   return T();
 }
 
+template <class T> void Curve<T>::sample(const float* positions, T* out, int count) const {
+  if (num_keys <= 1) {
+    std::fill(out, out + count, values[0]);
+    return;
+  }
+  if (interp != InterpType::linear) {
+    for (int n = 0; n < count; n++)
+      out[n] = sample(positions[n]);
+    return;
+  }
+  for (int n = 0; n < count; n++) {
+    float position = positions[n];
+    PASSERT(position >= 0.0f && position <= 1.0f);
+    int id = 0;
+    while (keys[id] < position)
+      id++;
+    id = max(0, id - 1);
+    out[n] = lerp(values[id], values[id + 1], (position - keys[id]) * scale[id]);
+  }
+}
+
 template <class T> void Curve<T>::print(int num_steps) const {
   /*if constexpr (std::is_same<T, float>()) {
     printf("Values: ");
@@ -115,6 +136,21 @@ template <class T> void Curve<T>::print(int num_steps) const {
   printf("\n");*/
 }
 
+static size_t hashValue(float value) {
+  return combineHash(value);
+}
+
+template <class T> static size_t hashValue(const T& value) {
+  return combineHashIter(std::begin(value.v), std::end(value.v));
+}
+
+template <class T> size_t Curve<T>::getHash() const {
+  size_t ret = combineHash(num_keys, interp);
+  for (int n = 0; n < num_keys; n++)
+    ret = combineHash(ret, keys[n], hashValue(values[n]));
+  return ret;
+}
+
 template struct Curve<float>;
 template struct Curve<FVec2>;
 template struct Curve<FVec3>;
@@ -20,6 +20,11 @@ template <class T> struct Curve {
 
   // Position is always within range: <0, 1>
   T sample(float position) const;
+  // Same as calling sample for each position, but constant and linear curves are handled without
+  // per-element dispatch
+  void sample(const float* positions, T* out, int count) const;
+  bool isConstant() const { return num_keys <= 1; }
+  size_t getHash() const;
 
   void print(int num_steps = 20) const;
 
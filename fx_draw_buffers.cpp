@@ -5,6 +5,8 @@
 
 namespace fx {
 
+DrawBuffers::DrawBuffers(EnumSet<TextureName> groupedTextures) : groupedTextures(groupedTextures) {}
+
 void DrawBuffers::clear() {
   positions.clear();
   texCoords.clear();
@@ -17,36 +19,44 @@ void DrawBuffers::add(const DrawParticle* particles, int count) {
     return;
 
   PROFILE;
-  auto& first = particles[0];
-  if (elements.empty())
-    elements.emplace_back(Element{0, 0, first.texName});
-
-  // TODO: sort particles by texture ?
+  bool anyGrouped = false;
   for (int n = 0; n < count; n++) {
     auto& quad = particles[n];
-    auto* last = &elements.back();
-    if (last->texName != quad.texName) {
-      Element new_elem{(int)positions.size(), 0, quad.texName};
-      elements.emplace_back(new_elem);
-      last = &elements.back();
-    }
-    last->numVertices += 4;
-
-    positions.insert(positions.end(), begin(quad.positions), end(quad.positions));
-    texCoords.insert(texCoords.end(), begin(quad.texCoords), end(quad.texCoords));
-
-    union {
-      struct {
-        unsigned char r, g, b, a;
-      } channels;
-      unsigned int ivalue;
-      };
-
-      channels.r = quad.color.r;
-      channels.g = quad.color.g;
-      channels.b = quad.color.b;
-      channels.a = quad.color.a;
-      colors.resize(colors.size() + 4, ivalue);
+    if (groupedTextures.contains(quad.texName)) {
+      groupedQuads[quad.texName].push_back(n);
+      anyGrouped = true;
+    } else
+      addQuad(quad);
   }
+
+  if (anyGrouped)
+    for (auto texName : ENUM_ALL(TextureName)) {
+      auto& indices = groupedQuads[texName];
+      for (int n : indices)
+        addQuad(particles[n]);
+      indices.clear();
+    }
+}
+
+void DrawBuffers::addQuad(const DrawParticle& quad) {
+  if (elements.empty() || elements.back().texName != quad.texName)
+    elements.emplace_back(Element{(int)positions.size(), 0, quad.texName});
+  elements.back().numVertices += 4;
+
+  positions.insert(positions.end(), begin(quad.positions), end(quad.positions));
+  texCoords.insert(texCoords.end(), begin(quad.texCoords), end(quad.texCoords));
+
+  union {
+    struct {
+      unsigned char r, g, b, a;
+    } channels;
+    unsigned int ivalue;
+  };
+
+  channels.r = quad.color.r;
+  channels.g = quad.color.g;
+  channels.b = quad.color.b;
+  channels.a = quad.color.a;
+  colors.resize(colors.size() + 4, ivalue);
 }
 }
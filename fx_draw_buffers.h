@@ -1,6 +1,7 @@
 #pragma once
 
 #include "fx_base.h"
+#include "fx_texture_name.h"
 
 namespace fx {
 
@@ -11,6 +12,10 @@ struct DrawBuffers {
     TextureName texName;
   };
 
+  // Quads with grouped textures are merged into a single element per texture for each add() call.
+  // This changes their drawing order, so only textures with order-independent (additive) blending should be grouped.
+  DrawBuffers(EnumSet<TextureName> groupedTextures = {});
+
   void clear();
   // TODO: span would be useful
   void add(const DrawParticle*, int count);
@@ -22,7 +27,12 @@ struct DrawBuffers {
   vector<FVec2> texCoords;
   vector<unsigned int> colors;
 
-  // TODO: group elements by TextureName
   vector<Element> elements;
+
+  private:
+  void addQuad(const DrawParticle&);
+
+  EnumSet<TextureName> groupedTextures;
+  EnumMap<TextureName, vector<int>> groupedQuads;
 };
 }
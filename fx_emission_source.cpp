@@ -17,6 +17,10 @@ float EmissionSource::sphereRadius() const {
   return param.x;
 }
 
+size_t EmissionSource::getHash() const {
+  return combineHash(pos.x, pos.y, param.x, param.y, type);
+}
+
 FVec2 EmissionSource::sample(RandomGen &rand) const {
   switch (type) {
   case Type::point:
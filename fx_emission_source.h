@@ -26,6 +26,8 @@ class EmissionSource {
   // TODO(opt): sample multiple points at once
   FVec2 sample(RandomGen &) const;
 
+  size_t getHash() const;
+
   private:
   FVec2 pos, param;
   Type type;
@@ -7,6 +7,9 @@
 
 namespace fx {
 
+// After changing how an effect is simulated, increase fxCodeVersion in fx_snapshot_cache.cpp, so that its cached
+// snapshots are generated again.
+
 // TODO: normalize it ?
 static const FVec2 dirVecs[8] = {
   {0.0, -1.0}, {0.0, 1.0},   {1.0, 0.0}, {-1.0, 0.0},
@@ -5,6 +5,8 @@
 #include "fx_particle_system.h"
 #include "fx_rect.h"
 #include "clock.h"
+#include "thread_pool.h"
+#include "fx_snapshot_cache.h"
 
 namespace fx {
 
@@ -12,10 +14,16 @@ static FXManager *s_instance = nullptr;
 
 FXManager *FXManager::getInstance() { return s_instance; }
 
-FXManager::FXManager() {
+FXManager::FXManager(optional<FilePath> snapshotCachePath) {
   randomGen = unique<RandomGen>();
+  if (snapshotCachePath)
+    snapshotCache = unique<SnapshotCache>(*snapshotCachePath);
   initializeTextureDefs();
   initializeDefs();
+  if (snapshotCache) {
+    snapshotCache->save();
+    snapshotCache.reset();
+  }
   CHECK(s_instance == nullptr && "There can be only one!");
   s_instance = this;
 }
@@ -65,7 +73,7 @@ void FXManager::simulateStable(double timeDelta, int visibleFps, int simulateFps
   accumFrameTime = timeDelta;
 }
 
-void FXManager::simulate(ParticleSystem &ps, float timeDelta) {
+void FXManager::simulate(ParticleSystem &ps, float timeDelta, ParticleBatch &batch) {
   PROFILE;
   auto &psdef = (*this)[ps.defId];
 
@@ -77,8 +85,11 @@ void FXManager::simulate(ParticleSystem &ps, float timeDelta) {
     AnimationContext ctx(ssctx(ps, ssid), globalSimTime, ps.animTime, timeDelta);
     ctx.rand.init(ss.randomSeed);
 
-    for (auto &pinst : ss.particles)
-      ssdef.animateFunc(ctx, pinst);
+    if (ssdef.animateFunc == defaultAnimateParticle)
+      animateParticles(ctx, ss.particles, batch);
+    else
+      for (auto &pinst : ss.particles)
+        ssdef.animateFunc(ctx, pinst);
 
     ss.randomSeed = ctx.randomSeed();
   }
@@ -161,11 +172,63 @@ void FXManager::simulate(ParticleSystem &ps, float timeDelta) {
   }
 }
 
+void FXManager::setNumThreads(int numThreads) {
+  if (numThreads > 0)
+    threadPool = unique<ThreadPool>(numThreads);
+  else
+    threadPool.reset();
+}
+
 void FXManager::simulate(float delta) {
   PROFILE;
+  // Below this number of particles it's not worth to wake up the workers
+  static constexpr int minParallelParticles = 1024;
+  // Cost of a system with no particles, relative to a single particle
+  static constexpr int systemCost = 16;
+
+  int totalCost = 0, totalParticles = 0;
   for (auto& inst : systems)
-    if (!inst.isDead)
-      simulate(inst, delta);
+    if (!inst.isDead) {
+      int numParticles = inst.numActiveParticles();
+      totalParticles += numParticles;
+      totalCost += numParticles + systemCost;
+    }
+
+  if (!threadPool || totalParticles < minParallelParticles) {
+    for (auto& inst : systems)
+      if (!inst.isDead)
+        simulate(inst, delta, particleBatch);
+    globalSimTime += delta;
+    return;
+  }
+
+  // Splitting systems into contiguous ranges with similar number of particles
+  int numJobs = threadPool->getNumThreads() * 2;
+  int jobCost = (totalCost + numJobs - 1) / numJobs;
+  jobRanges.clear();
+  int rangeStart = 0, rangeCost = 0;
+  for (int n = 0; n < (int)systems.size(); n++) {
+    auto& inst = systems[n];
+    if (inst.isDead)
+      continue;
+    rangeCost += inst.numActiveParticles() + systemCost;
+    if (rangeCost >= jobCost) {
+      jobRanges.emplace_back(rangeStart, n + 1);
+      rangeStart = n + 1;
+      rangeCost = 0;
+    }
+  }
+  if (rangeStart < (int)systems.size())
+    jobRanges.emplace_back(rangeStart, (int)systems.size());
+
+  if (jobBatches.size() < jobRanges.size())
+    jobBatches.resize(jobRanges.size());
+  threadPool->forEach(jobRanges.size(), [&](int job) {
+    PROFILE_BLOCK("FXManager::simulate job");
+    for (int n = jobRanges[job].first; n < jobRanges[job].second; n++)
+      if (!systems[n].isDead)
+        simulate(systems[n], delta, jobBatches[job]);
+  });
   globalSimTime += delta;
 }
 
@@ -205,12 +268,24 @@ void FXManager::genSnapshots(FXName name, vector<float> animTimes, vector<float>
   static constexpr float fps = 60.0f;
   std::sort(begin(animTimes), end(animTimes));
 
+  auto cacheKey = SnapshotCache::getKey(*this, name, animTimes, params, randomVariants);
+  if (snapshotCache)
+    if (auto groups = snapshotCache->get(cacheKey)) {
+      snapshotGroups[name] = *groups;
+      INFO << "FX: loaded cached snapshots for: " << ENUM_STRING(name);
+      return;
+    }
+
+  // Snapshots don't depend on the order in which they are generated or on the cache contents
+  RandomGen random;
+  random.init(int(cacheKey));
+
   int numSnapshots = 0;
   for (float param0 : params) {
     for (int r = 0; r < randomVariants; r++) {
-      auto ps = makeSystem(name, 0, {});
+      auto ps = makeSystem(name, 0, {}, random);
 
-      ps.randomize(*randomGen);
+      ps.randomize(random);
       ps.params.scalar[0] = param0;
 
       float curTime = 0.0f;
@@ -220,7 +295,7 @@ void FXManager::genSnapshots(FXName name, vector<float> animTimes, vector<float>
         float simTime = time - curTime;
         while (simTime > 0.0001f) {
           float stepTime = min(1.0f / fps, simTime);
-          simulate(ps, stepTime);
+          simulate(ps, stepTime, particleBatch);
           simTime -= stepTime;
         }
         curTime = time;
@@ -230,6 +305,9 @@ void FXManager::genSnapshots(FXName name, vector<float> animTimes, vector<float>
     }
   }
 
+  if (snapshotCache)
+    snapshotCache->add(cacheKey, snapshotGroups[name]);
+
   auto time = double(Clock::getRealMicros().count() - startTime) / 1000.0;
   float maxTime = animTimes.back();
   int numFrames = maxTime * fps;
@@ -259,6 +337,8 @@ void FXManager::genQuads(vector<DrawParticle>& out, int id, int ssid) {
     for (auto& pinst : ss.particles) {
       ctx.ssdef.multiDrawFunc(ctx, pinst, out, ps.color);
     }
+  else if (ctx.ssdef.drawFunc == defaultDrawParticle)
+    drawParticles(ctx, ss.particles, ps.color, particleBatch, out);
   else
     for (auto& pinst : ss.particles) {
       DrawParticle dparticle;
@@ -295,10 +375,10 @@ const ParticleSystem& FXManager::get(ParticleSystemId id) const {
   return systems[id];
 }
 
-ParticleSystem FXManager::makeSystem(FXName name, uint spawnTime, InitConfig config) {
+ParticleSystem FXManager::makeSystem(FXName name, uint spawnTime, InitConfig config, RandomGen& random) {
   if (config.snapshotKey)
     if (auto* ssGroup = findSnapshotGroup(name, *config.snapshotKey)) {
-      int index = randomGen->get(ssGroup->snapshots.size());
+      int index = random.get(ssGroup->snapshots.size());
       auto& key = ssGroup->key;
       INFO << "FX: using snapshot: " << ENUM_STRING(name) << " (" << key.scalar[0] << ", " << key.scalar[1] << ")";
       return ParticleSystem(name, config, spawnTime, ssGroup->snapshots[index]);
@@ -308,7 +388,7 @@ ParticleSystem FXManager::makeSystem(FXName name, uint spawnTime, InitConfig con
   ParticleSystem out(name, config, spawnTime, vector<ParticleSystem::SubSystem>((int)def.subSystems.size()));
   for (int ssid = 0; ssid < (int)out.subSystems.size(); ssid++) {
     auto& ss = out.subSystems[ssid];
-    ss.randomSeed = randomGen->get(INT_MAX);
+    ss.randomSeed = random.get(INT_MAX);
     ss.emissionFract = def.subSystems[ssid].emitter.initialSpawnCount;
   }
 
@@ -325,11 +405,11 @@ ParticleSystemId FXManager::addSystem(FXName name, InitConfig config) {
           spawnClock = 1;
       }
 
-      systems[n] = makeSystem(name, spawnClock, config);
+      systems[n] = makeSystem(name, spawnClock, config, *randomGen);
       return ParticleSystemId(n, spawnClock);
     }
 
-  systems.emplace_back(makeSystem(name, spawnClock, config));
+  systems.emplace_back(makeSystem(name, spawnClock, config, *randomGen));
   return ParticleSystemId(systems.size() - 1, spawnClock);
 }
 
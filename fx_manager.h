@@ -3,15 +3,22 @@
 #include "fx_base.h"
 #include "util.h"
 #include "fx_particle_system.h"
+#include "fx_particle_batch.h"
 #include "fx_defs.h"
 #include "fx_name.h"
 #include "fx_texture_name.h"
+#include "file_path.h"
+
+class ThreadPool;
 
 namespace fx {
 
+class SnapshotCache;
+
 class FXManager {
 public:
-  FXManager();
+  // Generated snapshots are cached in given file
+  FXManager(optional<FilePath> snapshotCachePath = none);
   ~FXManager();
 
   FXManager(const FXManager &) = delete;
@@ -28,6 +35,10 @@ public:
   void simulateStable(double timeDelta, int visibleFps = 60, int simulateFps = 60);
   void simulate(float timeDelta);
 
+  // Particle systems are independent (each subsystem has its own random seed), so they can be
+  // simulated in parallel; results don't depend on the number of threads. 0 means simulating on the caller thread.
+  void setNumThreads(int);
+
   const auto& getTextureDefs() const { return textureDefs; }
   const auto& getSystemDefs() const { return systemDefs; }
 
@@ -63,14 +74,14 @@ public:
   void addDef(FXName, ParticleSystemDef);
 
   private:
-  ParticleSystem makeSystem(FXName, uint spawnTime, InitConfig);
+  ParticleSystem makeSystem(FXName, uint spawnTime, InitConfig, RandomGen&);
 
   // Implemented in fx_factory.cpp:
   void initializeDefs();
   void initializeTextureDefs();
   void initializeTextureDef(TextureName, TextureDef&);
 
-  void simulate(ParticleSystem &, float timeDelta);
+  void simulate(ParticleSystem &, float timeDelta, ParticleBatch &);
   SubSystemContext ssctx(ParticleSystem &, int);
 
   EnumMap<FXName, ParticleSystemDef> systemDefs;
@@ -80,9 +91,14 @@ public:
   // TODO: add simple statistics: num particles, instances, etc.
   vector<ParticleSystem> systems;
   unique_ptr<RandomGen> randomGen;
+  unique_ptr<SnapshotCache> snapshotCache;
   uint spawnClock = 1;
   double accumFrameTime = 0.0f;
   double oldTime = -1.0;
   double globalSimTime = 0.0;
+  ParticleBatch particleBatch;
+  unique_ptr<ThreadPool> threadPool;
+  vector<ParticleBatch> jobBatches;
+  vector<pair<int, int>> jobRanges;
 };
 }
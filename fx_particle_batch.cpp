@@ -0,0 +1,107 @@
+#include "fx_particle_batch.h"
+
+#include "fx_color.h"
+#include "fx_curve.h"
+#include "fx_defs.h"
+#include "fx_particle_system.h"
+#include "fx_rect.h"
+
+namespace fx {
+
+void ParticleBatch::resize(int count) {
+  times.resize(count);
+  values.resize(count);
+  sizes.resize(count);
+  colors.resize(count);
+}
+
+static void computeParticleTimes(const vector<Particle>& particles, ParticleBatch& batch) {
+  batch.resize(particles.size());
+  auto* times = batch.times.data();
+  for (int n = 0; n < (int)particles.size(); n++)
+    times[n] = particles[n].particleTime();
+}
+
+void animateParticles(AnimationContext& ctx, vector<Particle>& particles, ParticleBatch& batch) {
+  PROFILE;
+  const auto& slowdownCurve = ctx.pdef.slowdown;
+  float timeDelta = ctx.timeDelta;
+  auto* data = particles.data();
+  int count = particles.size();
+  if (slowdownCurve.isConstant()) {
+    // The slowdown factor is the same for all particles, so we can skip the curve and pow entirely
+    float slowdown = 1.0f / (1.0f + slowdownCurve.sample(0.0f));
+    if (slowdown < 1.0f) {
+      float factor = pow(slowdown, timeDelta);
+      for (int n = 0; n < count; n++) {
+        auto& pinst = data[n];
+        pinst.pos += pinst.movement * timeDelta;
+        pinst.rot += pinst.rotSpeed * timeDelta;
+        pinst.movement *= factor;
+        pinst.rotSpeed *= factor;
+        pinst.life += timeDelta;
+      }
+    } else
+      for (int n = 0; n < count; n++) {
+        auto& pinst = data[n];
+        pinst.pos += pinst.movement * timeDelta;
+        pinst.rot += pinst.rotSpeed * timeDelta;
+        pinst.life += timeDelta;
+      }
+    return;
+  }
+  computeParticleTimes(particles, batch);
+  auto* slowdowns = batch.values.data();
+  slowdownCurve.sample(batch.times.data(), slowdowns, count);
+  for (int n = 0; n < count; n++) {
+    auto& pinst = data[n];
+    float slowdown = 1.0f / (1.0f + slowdowns[n]);
+    pinst.pos += pinst.movement * timeDelta;
+    pinst.rot += pinst.rotSpeed * timeDelta;
+    if (slowdown < 1.0f) {
+      float factor = pow(slowdown, timeDelta);
+      pinst.movement *= factor;
+      pinst.rotSpeed *= factor;
+    }
+    pinst.life += timeDelta;
+  }
+}
+
+void drawParticles(DrawContext& ctx, const vector<Particle>& particles, Color systemColor, ParticleBatch& batch,
+    vector<DrawParticle>& out) {
+  PROFILE;
+  const auto& pdef = ctx.pdef;
+  int count = particles.size();
+  computeParticleTimes(particles, batch);
+  auto* times = batch.times.data();
+  auto* alphas = batch.values.data();
+  auto* sizes = batch.sizes.data();
+  auto* colors = batch.colors.data();
+  pdef.alpha.sample(times, alphas, count);
+  pdef.size.sample(times, sizes, count);
+  pdef.color.sample(times, colors, count);
+
+  bool additive = ctx.tdef.blendMode == BlendMode::additive;
+  FVec3 systemColorMul = ctx.ps.params.color[0];
+  bool singleTile = ctx.tdef.tiles == IVec2(1, 1);
+  auto singleTileCoords = ctx.texQuadCorners(SVec2(0, 0));
+  out.reserve(out.size() + count);
+  for (int n = 0; n < count; n++) {
+    float alpha = alphas[n];
+    if (alpha < 1.0f / 255.0f)
+      continue;
+    auto& pinst = particles[n];
+    FVec2 pos = pinst.pos + ctx.ps.pos;
+    FVec2 size(sizes[n] * pinst.size);
+    FVec3 colorMul = systemColorMul;
+    if (additive)
+      colorMul *= alpha;
+    DrawParticle dparticle;
+    dparticle.positions = ctx.quadCorners(pos, size, pinst.rot);
+    dparticle.texCoords = singleTile ? singleTileCoords : ctx.texQuadCorners(pinst.texTile);
+    dparticle.color = Color(FColor(colors[n] * colorMul, alpha)).blend(systemColor);
+    dparticle.texName = pdef.textureName;
+    out.push_back(dparticle);
+  }
+}
+}
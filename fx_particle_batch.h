@@ -0,0 +1,27 @@
+#pragma once
+
+#include "fx_base.h"
+#include "fx_vec.h"
+
+class Color;
+
+namespace fx {
+
+// Per-particle values computed in bulk by the default animation and drawing kernels.
+// They are kept in separate arrays, so that curves are sampled in one pass
+// and the loops over them can be vectorized by the compiler.
+struct ParticleBatch {
+  void resize(int);
+
+  vector<float> times;
+  vector<float> values;
+  vector<float> sizes;
+  vector<FVec3> colors;
+};
+
+// Gives the same results as calling defaultAnimateParticle for each particle
+void animateParticles(AnimationContext&, vector<Particle>&, ParticleBatch&);
+
+// Gives the same results as calling defaultDrawParticle for each particle and blending it with the system color
+void drawParticles(DrawContext&, const vector<Particle>&, Color, ParticleBatch&, vector<DrawParticle>&);
+}
@@ -26,7 +26,9 @@ struct FXRenderer::SystemDrawInfo {
 FXRenderer::FXRenderer(DirectoryPath dataPath, FXManager& mgr) : mgr(mgr), texturesPath(dataPath) {
   useFramebuffer = isOpenglFeatureAvailable(OpenglFeature::FRAMEBUFFER) &&
                    isOpenglFeatureAvailable(OpenglFeature::SEPARATE_BLEND_FUNC);
-  drawBuffers = unique<DrawBuffers>();
+  // Additive blending doesn't depend on drawing order, so these quads can be batched by texture
+  drawBuffers = unique<DrawBuffers>(EnumSet<TextureName>(
+      [&](TextureName texName) { return mgr[texName].blendMode == BlendMode::additive; }));
 }
 
 void FXRenderer::loadTextures() {
@@ -0,0 +1,203 @@
+#include "fx_snapshot_cache.h"
+
+#include "fx_defs.h"
+#include "fx_particle_system.h"
+#include "version.h"
+
+namespace fx {
+
+// Increase it whenever the file layout changes
+static constexpr int32_t cacheVersion = 1;
+// Increase it whenever a change of the effect functions in fx_factory.cpp or of the particle simulation changes
+// the generated snapshots. The key only sees the effect definitions and the offsets of their functions, and
+// these often stay the same after such a change.
+static constexpr int32_t fxCodeVersion = 1;
+static constexpr uint32_t cacheMagic = 0x43535846; // "FXSC"
+// Protects from huge allocations when reading a damaged file
+static constexpr int32_t maxCount = 1 << 20;
+
+static uint64_t getBuildHash() {
+  return combineHash(string(BUILD_VERSION), int(sizeof(Particle)), int(sizeof(ParticleSystem::SubSystem)));
+}
+
+// Function pointers are hashed relative to a known function, so that the key doesn't depend on where
+// the executable was loaded. The offsets only change with the code layout, so they don't catch every change of
+// the functions, see fxCodeVersion.
+template <class Func> static size_t hashFunc(Func func) {
+  if (!func)
+    return 0;
+  return combineHash(
+      (long long)(reinterpret_cast<intptr_t>(func) - reinterpret_cast<intptr_t>(&defaultAnimateParticle)));
+}
+
+template <class T> static size_t hashCurves(const vector<Curve<T>>& curves) {
+  size_t ret = combineHash(int(curves.size()));
+  for (auto& curve : curves)
+    ret = combineHash(ret, curve.getHash());
+  return ret;
+}
+
+uint64_t SnapshotCache::getKey(const FXManager& manager, FXName name, const vector<float>& animTimes,
+                               const vector<float>& params, int randomVariants) {
+  auto& def = manager[name];
+  size_t ret = combineHash(fxCodeVersion, name, combineHashIter(animTimes.begin(), animTimes.end()),
+                           combineHashIter(params.begin(), params.end()), randomVariants, def.isLooped,
+                           def.animLength);
+  for (auto& ssdef : def.subSystems) {
+    auto& pdef = ssdef.particle;
+    auto& edef = ssdef.emitter;
+    auto& tdef = manager[pdef.textureName];
+    ret = combineHash(ret, pdef.life.getHash(), pdef.alpha.getHash(), pdef.size.getHash(), pdef.slowdown.getHash(),
+                      pdef.color.getHash(), hashCurves(pdef.scalarCurves), hashCurves(pdef.colorCurves),
+                      pdef.textureName, tdef.tiles.x, tdef.tiles.y);
+    ret = combineHash(ret, edef.source.getHash(), edef.frequency.getHash(), edef.strength.getHash(),
+                      edef.strengthSpread.getHash(), edef.direction.getHash(), edef.directionSpread.getHash(),
+                      edef.rotSpeed.getHash(), edef.rotSpeedSpread.getHash(), hashCurves(edef.scalarCurves),
+                      hashCurves(edef.colorCurves), edef.initialSpawnCount);
+    ret = combineHash(ret, ssdef.emissionStart, ssdef.emissionEnd, hashFunc(ssdef.animateFunc),
+                      hashFunc(ssdef.prepareFunc), hashFunc(ssdef.emitFunc), ssdef.maxActiveParticles,
+                      ssdef.maxTotalParticles);
+  }
+  return ret;
+}
+
+SnapshotCache::SnapshotCache(FilePath path) : path(path) {
+  load();
+}
+
+const vector<SnapshotCache::SnapshotGroup>* SnapshotCache::get(uint64_t key) {
+  auto it = entries.find(key);
+  if (it == entries.end())
+    return nullptr;
+  it->second.used = true;
+  return &it->second.groups;
+}
+
+void SnapshotCache::add(uint64_t key, vector<SnapshotGroup> groups) {
+  entries[key] = Entry{std::move(groups), true};
+  changed = true;
+}
+
+template <class T> static void writeValue(ostream& out, const T& value) {
+  static_assert(std::is_trivially_copyable<T>::value, "");
+  out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template <class T> static void writeValues(ostream& out, const vector<T>& values) {
+  static_assert(std::is_trivially_copyable<T>::value, "");
+  writeValue(out, int32_t(values.size()));
+  out.write(reinterpret_cast<const char*>(values.data()), values.size() * sizeof(T));
+}
+
+template <class T> static bool readValue(istream& in, T& value) {
+  static_assert(std::is_trivially_copyable<T>::value, "");
+  return !!in.read(reinterpret_cast<char*>(&value), sizeof(T));
+}
+
+static bool readCount(istream& in, int32_t& count) {
+  return readValue(in, count) && count >= 0 && count <= maxCount;
+}
+
+template <class T> static bool readValues(istream& in, vector<T>& values) {
+  int32_t count;
+  if (!readCount(in, count))
+    return false;
+  values.resize(count);
+  return !!in.read(reinterpret_cast<char*>(values.data()), count * sizeof(T));
+}
+
+static bool readSubSystem(istream& in, ParticleSystem::SubSystem& ss) {
+  return readValue(in, ss.animationVars) && readValue(in, ss.emissionFract) && readValue(in, ss.randomSeed) &&
+         readValue(in, ss.totalParticles) && readValues(in, ss.particles);
+}
+
+static bool readGroup(istream& in, SnapshotCache::SnapshotGroup& group) {
+  int32_t numSnapshots;
+  if (!readValue(in, group.key) || !readCount(in, numSnapshots))
+    return false;
+  group.snapshots.resize(numSnapshots);
+  for (auto& snapshot : group.snapshots) {
+    int32_t numSubSystems;
+    if (!readCount(in, numSubSystems))
+      return false;
+    snapshot.resize(numSubSystems);
+    for (auto& ss : snapshot)
+      if (!readSubSystem(in, ss))
+        return false;
+  }
+  return true;
+}
+
+void SnapshotCache::load() {
+  ifstream in(path.getPath(), std::ios::binary);
+  if (!in)
+    return;
+  uint32_t magic;
+  int32_t version;
+  uint64_t buildHash;
+  int32_t numEntries;
+  if (!readValue(in, magic) || !readValue(in, version) || !readValue(in, buildHash) ||
+      magic != cacheMagic || version != cacheVersion || buildHash != getBuildHash() || !readCount(in, numEntries)) {
+    INFO << "FX: ignoring outdated snapshot cache " << path;
+    return;
+  }
+  for (int n = 0; n < numEntries; n++) {
+    uint64_t key;
+    int32_t numGroups;
+    if (!readValue(in, key) || !readCount(in, numGroups))
+      break;
+    Entry entry{vector<SnapshotGroup>(numGroups), false};
+    bool ok = true;
+    for (auto& group : entry.groups)
+      if (!(ok = readGroup(in, group)))
+        break;
+    if (!ok)
+      break;
+    entries[key] = std::move(entry);
+  }
+  if (!in) {
+    INFO << "FX: snapshot cache " << path << " is damaged";
+    entries.clear();
+  }
+  INFO << "FX: loaded " << entries.size() << " cached snapshot sets";
+}
+
+void SnapshotCache::save() const {
+  bool anyUnused = false;
+  for (auto& elem : entries)
+    anyUnused |= !elem.second.used;
+  if (!changed && !anyUnused)
+    return;
+  ofstream out(path.getPath(), std::ios::binary);
+  writeValue(out, cacheMagic);
+  writeValue(out, cacheVersion);
+  writeValue(out, getBuildHash());
+  int32_t numEntries = 0;
+  for (auto& elem : entries)
+    if (elem.second.used)
+      numEntries++;
+  writeValue(out, numEntries);
+  for (auto& elem : entries) {
+    if (!elem.second.used)
+      continue;
+    writeValue(out, elem.first);
+    writeValue(out, int32_t(elem.second.groups.size()));
+    for (auto& group : elem.second.groups) {
+      writeValue(out, group.key);
+      writeValue(out, int32_t(group.snapshots.size()));
+      for (auto& snapshot : group.snapshots) {
+        writeValue(out, int32_t(snapshot.size()));
+        for (auto& ss : snapshot) {
+          writeValue(out, ss.animationVars);
+          writeValue(out, ss.emissionFract);
+          writeValue(out, ss.randomSeed);
+          writeValue(out, ss.totalParticles);
+          writeValues(out, ss.particles);
+        }
+      }
+    }
+  }
+  if (!out)
+    INFO << "FX: failed to write snapshot cache " << path;
+}
+}
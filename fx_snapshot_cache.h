@@ -0,0 +1,39 @@
+#pragma once
+
+#include "fx_base.h"
+#include "fx_manager.h"
+#include "file_path.h"
+
+namespace fx {
+
+// Snapshots generated by FXManager::genSnapshots, stored on disk so that they don't have to be
+// simulated at every startup. Entries are keyed by a hash of everything which affects the simulation
+// (see getKey); the whole file is discarded when it was written by a different build.
+class SnapshotCache {
+  public:
+  using SnapshotGroup = FXManager::SnapshotGroup;
+
+  SnapshotCache(FilePath);
+
+  static uint64_t getKey(const FXManager&, FXName, const vector<float>& animTimes, const vector<float>& params,
+                         int randomVariants);
+
+  const vector<SnapshotGroup>* get(uint64_t key);
+  void add(uint64_t key, vector<SnapshotGroup>);
+
+  // Writes entries which were used since loading; does nothing if all of them came from the file
+  void save() const;
+
+  private:
+  void load();
+
+  struct Entry {
+    vector<SnapshotGroup> groups;
+    bool used;
+  };
+
+  FilePath path;
+  unordered_map<uint64_t, Entry> entries;
+  bool changed = false;
+};
+}
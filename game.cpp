@@ -38,6 +38,15 @@
 #include "village_behaviour.h"
 #include "collective_builder.h"
 #include "game_event.h"
+#include "thread_pool.h"
+#include "tribe_alignment.h"
+#include "enemy_factory.h"
+#include "gzstream.h"
+#include "memory_report.h"
+
+static bool wasSaved(OutputArchive& ar, const void* object) {
+  return !(ar.registerSharedPointer(object) & cereal::detail::msb_32bit);
+}
 
 template <class Archive> 
 void Game::serialize(Archive& ar, const unsigned int version) {
@@ -47,10 +56,65 @@ void Game::serialize(Archive& ar, const unsigned int version) {
   ar(gameDisplayName, finishCurrentMusic, models, visited, baseModel, campaign, localTime, turnEvents);
   if (version >= 1)
     ar(sunlightTimeOffset);
+  if (version >= 2)
+    ar(lazySites);
+  else if (Archive::is_loading::value)
+    lazySites = Table<optional<LazySite>>(models.getBounds());
+  if (version >= 3)
+    ar(savedSites);
+  else if (Archive::is_loading::value)
+    savedSites = Table<optional<SavedSite>>(models.getBounds());
   if (Archive::is_loading::value)
     sunlightInfo.update(getGlobalTime() + sunlightTimeOffset);
 }
 
+namespace {
+class DiscardingBuffer : public std::streambuf {
+  protected:
+  std::streamsize xsputn(const char*, std::streamsize n) override {
+    return n;
+  }
+  int_type overflow(int_type c) override {
+    return traits_type::not_eof(c);
+  }
+};
+}
+
+void Game::save(OutputArchive& ar, PGame& game, bool separateSites) {
+  // Loading a site in the background uses the same static serialization state
+  if (game->backgroundThread)
+    game->backgroundThread->wait();
+  if (!separateSites) {
+    ar << game;
+    return;
+  }
+  while (1) {
+    vector<pair<Vec2, WModel>> separated;
+    auto joinSites = game->separateSites(separated);
+    auto checkedSites = make_pair(separated, game->referencedSites);
+    if (!separated.empty() && game->lastCheckedSites != checkedSites) {
+      // A separated site that is reached from the rest of the game would get a partial copy in the save,
+      // so the game is saved without output first to find such sites. They stay with the game from now on.
+      // The check is only repeated when the separated or the referenced sites change.
+      DiscardingBuffer buffer;
+      std::ostream stream(&buffer);
+      OutputArchive dryRun(stream);
+      dryRun << game;
+      bool referenced = false;
+      for (auto& site : separated)
+        if (wasSaved(dryRun, site.second)) {
+          game->referencedSites.insert(site.first);
+          referenced = true;
+        }
+      if (referenced)
+        continue;
+      game->lastCheckedSites = std::move(checkedSites);
+    }
+    ar << game;
+    return;
+  }
+}
+
 SERIALIZABLE(Game);
 SERIALIZATION_CONSTRUCTOR_IMPL(Game);
 
@@ -60,22 +124,26 @@ static string getGameId(SaveFileInfo info) {
 
 Game::Game(Table<PModel>&& m, Vec2 basePos, const CampaignSetup& c)
     : models(std::move(m)), visited(models.getBounds(), false), baseModel(basePos),
-      tribes(Tribe::generateTribes()), musicType(MusicType::PEACEFUL), campaign(c.campaign) {
+      tribes(Tribe::generateTribes()), musicType(MusicType::PEACEFUL), campaign(c.campaign),
+      lazySites(models.getBounds()), savedSites(models.getBounds()) {
   gameIdentifier = c.gameIdentifier;
   gameDisplayName = c.gameDisplayName;
   for (Vec2 v : models.getBounds())
-    if (WModel m = models[v].get()) {
-      for (WCollective col : m->getCollectives())
-        addCollective(col);
-      m->updateSunlightMovement();
-      for (auto c : m->getAllCreatures())
-        c->setGlobalTime(getGlobalTime());
-    }
+    if (WModel m = models[v].get())
+      addModel(m);
   turnEvents = {0, 10, 50, 100, 300, 500};
   for (int i : Range(200))
     turnEvents.insert(1000 * (i + 1));
 }
 
+void Game::addModel(WModel m) {
+  for (WCollective col : m->getCollectives())
+    addCollective(col);
+  m->updateSunlightMovement();
+  for (auto c : m->getAllCreatures())
+    c->setGlobalTime(getGlobalTime());
+}
+
 void Game::addCollective(WCollective col) {
   collectives.push_back(col);
   auto type = col->getVillainType();
@@ -113,13 +181,22 @@ void Game::spawnKeeper(AvatarInfo avatarInfo, bool regenerateMana, vector<string
     playerCollective->acquireTech(tech, false);
 }
 
-Game::~Game() {}
+Game::~Game() {
+  // Waits for the background site, which could still be using this object
+  backgroundThread.reset();
+}
 
-PGame Game::campaignGame(Table<PModel>&& models, CampaignSetup& setup, AvatarInfo avatar, GameConfig* gameConfig,
+PGame Game::campaignGame(CampaignModels models, CampaignSetup& setup, AvatarInfo avatar, GameConfig* gameConfig,
     const CreatureFactory* creatureFactory) {
-  auto ret = makeOwner<Game>(std::move(models), *setup.campaign.getPlayerPos(), setup);
+  auto ret = makeOwner<Game>(std::move(models.models), *setup.campaign.getPlayerPos(), setup);
   for (auto model : ret->getAllModels())
     model->setGame(ret.get());
+  for (Vec2 v : models.lazySiteSeeds.getBounds())
+    if (auto seed = models.lazySiteSeeds[v]) {
+      auto villain = setup.campaign.getSites()[v].getVillain();
+      CHECK(!!villain);
+      ret->lazySites[v] = LazySite{villain->enemyId, villain->type, avatar.tribeAlignment, *seed};
+    }
   auto avatarCreature = avatar.playerCreature.get();
   if (avatarCreature->getAttributes().isAffectedPermanently(LastingEffect::SUNLIGHT_VULNERABLE))
     ret->sunlightTimeOffset = 1501_visible;
@@ -193,7 +270,26 @@ int Game::getSaveProgressCount() const {
   return saveTime;
 }
 
+void Game::addMemoryUsage(MemoryReport& report) const {
+  for (Vec2 v : models.getBounds())
+    if (models[v])
+      models[v]->addMemoryUsage(report.addChild(v == baseModel ? "Main site"_s : "Site " + toString(v)));
+  long long savedSize = 0;
+  for (Vec2 v : savedSites.getBounds())
+    if (auto& site = savedSites[v])
+      savedSize += site->data.capacity();
+  report.add("saved sites", savedSize);
+  long long cacheSize = 0;
+  for (auto& elem : savedSiteCache)
+    cacheSize += elem.second.site.data.capacity();
+  report.add("saved site cache", cacheSize);
+  if (playerControl)
+    report.add("map memory", static_cast<const CreatureView*>(playerControl)->getMemory().getMemoryUsage());
+}
+
 void Game::prepareSiteRetirement() {
+  if (backgroundThread)
+    backgroundThread->wait();
   for (Vec2 v : models.getBounds())
     if (models[v] && v != baseModel)
       models[v]->discardForRetirement();
@@ -306,6 +402,7 @@ optional<ExitInfo> Game::update(double timeDiff) {
   if (auto exitInfo = updateInput())
     return exitInfo;
   considerRealTimeRender();
+  updateLazySites();
   initializeModels();
   increaseTime(timeDiff);
   WModel currentModel = getCurrentModel();
@@ -374,6 +471,7 @@ void Game::tick(GlobalTime time) {
     if (isVillainActive(col))
       col->update(col->getModel() == getCurrentModel());
   }
+  Profiler::markEnd(ProfilerPeriod::TURN);
 }
 
 void Game::exitAction() {
@@ -449,6 +547,8 @@ void Game::presentWorldmap() {
 void Game::transferAction(vector<WCreature> creatures) {
   if (auto dest = view->chooseSite("Choose destination site:", *campaign,
         getModelCoords(creatures[0]->getLevel()->getModel()))) {
+    if (isLazySite(*dest))
+      generateLazySite(*dest);
     WModel to = NOTNULL(models[*dest].get());
     vector<CreatureInfo> cant;
     for (WCreature c : copyOf(creatures))
@@ -631,6 +731,194 @@ Options* Game::getOptions() {
   return options;
 }
 
+void Game::setSiteGenerator(SiteGenerator generator, bool useBackgroundThread) {
+  backgroundThread.reset();
+  backgroundSite = none;
+  backgroundModel.clear();
+  siteGenerator = std::move(generator);
+  if (useBackgroundThread)
+    backgroundThread = unique<ThreadPool>(1);
+}
+
+bool Game::isLazySite(Vec2 pos) const {
+  return !!lazySites[pos] || !!savedSites[pos];
+}
+
+// Returns none if the model refers to the rest of the game
+static optional<string> compressSite(const PModel& model, const Game* game, int& size) {
+  std::ostringstream stream;
+  {
+    OutputArchive archive(stream);
+    archive << model;
+    if (wasSaved(archive, game))
+      return none;
+  }
+  string data = stream.str();
+  size = data.size();
+  vector<Bytef> ret(compressBound(data.size()));
+  uLongf compressedSize = ret.size();
+  CHECK(compress(ret.data(), &compressedSize, reinterpret_cast<const Bytef*>(data.data()), data.size()) == Z_OK);
+  return string(reinterpret_cast<const char*>(ret.data()), compressedSize);
+}
+
+static PModel uncompressSite(const string& data, int size) {
+  string uncompressed(size, 0);
+  uLongf uncompressedSize = size;
+  CHECK(uncompress(reinterpret_cast<Bytef*>(&uncompressed[0]), &uncompressedSize,
+      reinterpret_cast<const Bytef*>(data.data()), data.size()) == Z_OK && uncompressedSize == uLongf(size))
+      << "Corrupted campaign site in saved game";
+  std::istringstream stream(uncompressed);
+  InputArchive archive(stream);
+  PModel ret;
+  archive >> ret;
+  return ret;
+}
+
+// Doesn't touch the game state, so it can run on the background thread
+PModel Game::makeLazySiteModel(Vec2 pos) const {
+  if (auto& site = savedSites[pos])
+    return uncompressSite(site->data, site->size);
+  CHECK(!!siteGenerator) << "No generator for lazy campaign sites";
+  auto& site = *lazySites[pos];
+  return siteGenerator(site.enemyId, site.villainType, site.alignment, site.seed);
+}
+
+void Game::generateLazySite(Vec2 pos) {
+  PModel model;
+  if (backgroundSite == pos) {
+    backgroundThread->wait();
+    model = std::move(backgroundModel);
+    backgroundSite = none;
+  } else
+    model = makeLazySiteModel(pos);
+  INFO << "Generated lazy campaign site " << pos;
+  lazySites[pos] = none;
+  savedSites[pos] = none;
+  models[pos] = std::move(model);
+  models[pos]->setGame(this);
+  addModel(models[pos].get());
+}
+
+void Game::updateLazySites() {
+  if (!campaign->getPlayerPos())
+    return;
+  auto playerPos = *campaign->getPlayerPos();
+  // Villains in influence are updated without going through their model
+  for (auto it = savedSiteCache.begin(); it != savedSiteCache.end();)
+    if (campaign->isInInfluence(it->first) || it->first == playerPos)
+      it = savedSiteCache.erase(it);
+    else
+      ++it;
+  optional<Vec2> nearest;
+  for (Vec2 v : lazySites.getBounds())
+    if (isLazySite(v)) {
+      if (campaign->isInInfluence(v) || v == playerPos)
+        generateLazySite(v);
+      else if (!nearest || v.distD(playerPos) < nearest->distD(playerPos))
+        nearest = v;
+    }
+  // The sites closest to the player will be the next ones to come into influence
+  if (backgroundThread && !backgroundSite && nearest) {
+    auto pos = *nearest;
+    backgroundSite = pos;
+    backgroundThread->addTask([this, pos] {
+      backgroundModel = makeLazySiteModel(pos);
+    });
+  }
+}
+
+bool Game::canSaveSeparately(Vec2 pos) const {
+  WModel model = models[pos].get();
+  if (!model || pos == baseModel || visited[pos] || model == getCurrentModel() || !campaign->getPlayerPos() ||
+      campaign->isInInfluence(pos) || referencedSites.count(pos))
+    return false;
+  for (auto c : players)
+    if (c->getPosition().getModel() == model)
+      return false;
+  // The model can't have any references to other models or be referenced by them
+  for (auto col : collectives) {
+    bool inside = col->getModel() == model;
+    for (auto c : col->getCreatures())
+      if ((c->getPosition().getModel() == model) != inside)
+        return false;
+  }
+  return true;
+}
+
+unique_ptr<OnExit> Game::separateSites(vector<pair<Vec2, WModel>>& separated) {
+  auto removedModels = make_shared<vector<pair<Vec2, PModel>>>();
+  auto allCollectives = collectives;
+  auto allVillains = villainsByType;
+  for (Vec2 v : models.getBounds())
+    if (canSaveSeparately(v)) {
+      WModel model = models[v].get();
+      auto cached = getReferenceMaybe(savedSiteCache, v);
+      if (!cached || cached->model != model || cached->changeCount != model->getChangeCount()) {
+        SavedSite site;
+        model->setGame(nullptr);
+        auto data = compressSite(models[v], this, site.size);
+        model->setGame(this);
+        if (!data) {
+          referencedSites.insert(v);
+          continue;
+        }
+        site.data = std::move(*data);
+        for (auto col : model->getCollectives())
+          if (col->isConquered())
+            site.conqueredVillainTypes.push_back(col->getVillainType());
+          else
+            site.villainTypes.push_back(col->getVillainType());
+        savedSiteCache[v] = CachedSite{model, model->getChangeCount(), std::move(site)};
+      }
+      savedSites[v] = savedSiteCache.at(v).site;
+      for (auto col : model->getCollectives()) {
+        collectives.removeElement(col);
+        villainsByType[col->getVillainType()].removeElement(col);
+      }
+      separated.push_back(make_pair(v, model));
+      removedModels->push_back(make_pair(v, std::move(models[v])));
+    }
+  if (removedModels->empty())
+    return nullptr;
+  return unique<OnExit>([this, removedModels, allCollectives, allVillains] {
+    for (auto& elem : *removedModels) {
+      savedSites[elem.first] = none;
+      models[elem.first] = std::move(elem.second);
+    }
+    collectives = allCollectives;
+    villainsByType = allVillains;
+  });
+}
+
+void Game::loadSavedSites() {
+  for (Vec2 v : savedSites.getBounds())
+    if (savedSites[v])
+      generateLazySite(v);
+}
+
+int Game::getNumLazyVillains(VillainType type) const {
+  int ret = 0;
+  for (Vec2 v : lazySites.getBounds()) {
+    if (lazySites[v] && lazySites[v]->villainType == type)
+      ++ret;
+    if (savedSites[v])
+      for (auto villainType : savedSites[v]->villainTypes)
+        if (villainType == type)
+          ++ret;
+  }
+  return ret;
+}
+
+int Game::getNumConqueredLazyVillains(VillainType type) const {
+  int ret = 0;
+  for (Vec2 v : savedSites.getBounds())
+    if (savedSites[v])
+      for (auto villainType : savedSites[v]->conqueredVillainTypes)
+        if (villainType == type)
+          ++ret;
+  return ret;
+}
+
 void Game::initialize(Options* o, Highscores* h, View* v, FileSharing* f, GameConfig* g,
     const CreatureFactory* fac) {
   options = o;
@@ -741,6 +1029,8 @@ void Game::handleMessageBoard(Position pos, WCreature c) {
 }
 
 bool Game::gameWon() const {
+  if (getNumLazyVillains(VillainType::MAIN) > 0)
+    return false;
   for (WCollective col : getCollectives())
     if (!col->isConquered() && col->getVillainType() == VillainType::MAIN)
       return false;
@@ -23,15 +23,38 @@ struct CampaignSetup;
 class GameConfig;
 class AvatarInfo;
 class CreatureFactory;
+class ThreadPool;
+class MemoryReport;
+
+// Models of the campaign sites. Villain sites without a model are generated when they are needed,
+// from the given seed.
+struct CampaignModels {
+  Table<PModel> models;
+  Table<optional<int>> lazySiteSeeds;
+};
 
 class Game : public OwnedObject<Game> {
   public:
-  static PGame campaignGame(Table<PModel>&&, CampaignSetup&, AvatarInfo, GameConfig*, const CreatureFactory*);
+  static PGame campaignGame(CampaignModels, CampaignSetup&, AvatarInfo, GameConfig*, const CreatureFactory*);
   static PGame splashScreen(PModel&&, const CampaignSetup&);
 
+  // All saving goes through here. Frozen campaign sites that the rest of the game doesn't refer to are
+  // compressed separately, unless separateSites is false.
+  static void save(OutputArchive&, PGame&, bool separateSites = true);
+  // Uncompresses the campaign sites that are still kept compressed since the game was loaded
+  void loadSavedSites();
+
   optional<ExitInfo> update(double timeDiff);
   Options* getOptions();
   void initialize(Options*, Highscores*, View*, FileSharing*, GameConfig*, const CreatureFactory*);
+
+  // Generates a villain site that wasn't generated at the start of the game. It has to give the same
+  // result for the same arguments, because the site is generated again every time a saved game is loaded
+  // before the site came into influence.
+  // With a background thread the generator runs while the game is played on the main thread. The generator
+  // must not touch the game or any state shared with it, see MainLoop::withSiteModelBuilder.
+  using SiteGenerator = function<PModel(EnemyId, VillainType, TribeAlignment, int seed)>;
+  void setSiteGenerator(SiteGenerator, bool useBackgroundThread);
   View* getView() const;
   GameConfig* getGameConfig() const;
   const CreatureFactory* getCreatureFactory() const;
@@ -60,6 +83,9 @@ class Game : public OwnedObject<Game> {
 
   const vector<WCollective>& getVillains(VillainType) const;
   const vector<WCollective>& getCollectives() const;
+  // Unconquered villains in sites that weren't generated or loaded yet, so they're not in getVillains()
+  int getNumLazyVillains(VillainType) const;
+  int getNumConqueredLazyVillains(VillainType) const;
 
   const SunlightInfo& getSunlightInfo() const;
   const string& getWorldName() const;
@@ -83,6 +109,7 @@ class Game : public OwnedObject<Game> {
   vector<WModel> getAllModels() const;
   bool isSingleModel() const;
   int getSaveProgressCount() const;
+  void addMemoryUsage(MemoryReport&) const;
   WModel getCurrentModel() const;
 
   void prepareSiteRetirement();
@@ -143,6 +170,47 @@ class Game : public OwnedObject<Game> {
   void addCollective(WCollective);
   void spawnKeeper(AvatarInfo, bool regenerateMana, vector<string> introText, GameConfig*, const CreatureFactory*);
   const CreatureFactory* creatureFactory = nullptr;
+  struct LazySite {
+    EnemyId SERIAL(enemyId);
+    VillainType SERIAL(villainType);
+    TribeAlignment SERIAL(alignment);
+    int SERIAL(seed);
+    SERIALIZE_ALL(enemyId, villainType, alignment, seed)
+  };
+  Table<optional<LazySite>> SERIAL(lazySites);
+  // Sites that are frozen outside of influence are written to binary saves as separately compressed
+  // models. After loading they are kept compressed, until they are needed like lazy sites.
+  struct SavedSite {
+    string SERIAL(data);
+    int SERIAL(size);
+    vector<VillainType> SERIAL(villainTypes);
+    vector<VillainType> SERIAL(conqueredVillainTypes);
+    SERIALIZE_ALL(data, size, villainTypes, conqueredVillainTypes)
+  };
+  Table<optional<SavedSite>> SERIAL(savedSites);
+  // Copies of separately saved sites from the last save, reused while the model doesn't change
+  struct CachedSite {
+    WModel model;
+    int changeCount;
+    SavedSite site;
+  };
+  map<Vec2, CachedSite> savedSiteCache;
+  SiteGenerator siteGenerator;
+  void addModel(WModel);
+  bool isLazySite(Vec2) const;
+  void updateLazySites();
+  void generateLazySite(Vec2);
+  PModel makeLazySiteModel(Vec2) const;
+  bool canSaveSeparately(Vec2) const;
+  // Takes the sites that can be saved separately out of the game, until the returned object is destroyed
+  unique_ptr<OnExit> separateSites(vector<pair<Vec2, WModel>>& separated);
+  set<Vec2> referencedSites;
+  // The separated and the referenced sites of the last save that found no references to separated sites
+  optional<pair<vector<pair<Vec2, WModel>>, set<Vec2>>> lastCheckedSites;
+  // The next site is generated in the background, ahead of the time it's needed
+  optional<Vec2> backgroundSite;
+  PModel backgroundModel;
+  unique_ptr<ThreadPool> backgroundThread;
 };
 
-CEREAL_CLASS_VERSION(Game, 1);
+CEREAL_CLASS_VERSION(Game, 3);
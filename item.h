@@ -32,7 +32,7 @@ struct CorpseInfo;
 class RangedWeapon;
 class WeaponInfo;
 
-class Item : public Renderable, public UniqueEntity<Item>, public OwnedObject<Item> {
+class Item : public Renderable, public UniqueEntity<Item>, public OwnedObject<Item>, public PoolAllocated {
   public:
   Item(const ItemAttributes&);
   virtual ~Item();
@@ -1,5 +1,6 @@
 #include "stdafx.h"
 #include "known_tiles.h"
+#include "memory_report.h"
 
 template <class Archive>
 void KnownTiles::serialize(Archive& ar, const unsigned int version) {
@@ -36,3 +37,7 @@ void KnownTiles::limitToModel(WConstModel m) {
   ::limitToModel(known, m);
   ::limitToModel(border, m);
 }
+
+long long KnownTiles::getMemoryUsage() const {
+  return MemoryReport::getSize(known) + MemoryReport::getSize(border);
+}
@@ -23,6 +23,7 @@ class KnownTiles {
   bool isKnown(Position) const;
   const PositionSet& getBorderTiles() const;
   void limitToModel(WConstModel);
+  long long getMemoryUsage() const;
 
   template <class Archive> 
   void serialize(Archive& ar, const unsigned int version);
@@ -40,6 +40,7 @@
 #include "portals.h"
 #include "roof_support.h"
 #include "game_event.h"
+#include "memory_report.h"
 
 template <class Archive> 
 void Level::serialize(Archive& ar, const unsigned int version) {
@@ -99,7 +100,7 @@ LevelId Level::getUniqueId() const {
 }
 
 Rectangle Level::getMaxBounds() {
-  return Rectangle(360, 360);
+  return Rectangle(1024, 1024);
 }
 
 Rectangle Level::getSplashBounds() {
@@ -537,6 +538,24 @@ int Level::getNumTotalSquares() const {
   return squares->getNumGenerated();
 }
 
+void Level::addMemoryUsage(MemoryReport& report) const {
+  auto& levelReport = report.addChild("Level " + name);
+  levelReport.add("squares", squares->getMemoryUsage());
+  levelReport.add("furniture", furniture->getMemoryUsage());
+  auto& fovReport = levelReport.addChild("field of view");
+  for (auto vision : ENUM_ALL(VisionId))
+    fovReport.add(EnumInfo<VisionId>::getString(vision), (*fieldOfView)[vision].getMemoryUsage());
+  long long sectorsSize = MemoryReport::getSize(sectors);
+  for (auto& elem : sectors)
+    sectorsSize += elem.second.getMemoryUsage();
+  levelReport.add("sectors", sectorsSize);
+  levelReport.add("light and sunlight", MemoryReport::getSize(sunlight) + MemoryReport::getSize(lightAmount) +
+      MemoryReport::getSize(lightCapAmount));
+  levelReport.add("other tables", MemoryReport::getSize(memoryUpdates) + renderUpdates.getMemoryUsage() +
+      MemoryReport::getSize(unavailable) + MemoryReport::getSize(covered));
+  levelReport.add("creatures", MemoryReport::getSize(creatures) + creatures.size() * sizeof(Creature));
+}
+
 void Level::setNeedsMemoryUpdate(Vec2 pos, bool s) {
   if (pos.inRectangle(getBounds()))
     memoryUpdates[pos] = s;
@@ -547,7 +566,8 @@ bool Level::needsRenderUpdate(Vec2 pos) const {
 }
 
 void Level::setNeedsRenderUpdate(Vec2 pos, bool s) {
-  renderUpdates[pos] = s;
+  if (renderUpdates[pos] != s)
+    renderUpdates.getWritable(pos) = s;
   setNeedsMemoryUpdate(pos, s);
 }
 
@@ -561,7 +581,7 @@ bool Level::isUnavailable(Vec2 pos) const {
 
 void Level::setFurniture(Vec2 pos, PFurniture f) {
   auto layer = f->getLayer();
-  furniture->getConstruction(pos, layer).reset();
+  furniture->clearConstruction(pos, layer);
   if (f->isTicking())
     addTickingFurniture(pos);
   furniture->getBuilt(layer).putElem(pos, std::move(f));
@@ -24,6 +24,7 @@
 #include "entity_set.h"
 #include "vision_id.h"
 #include "furniture_layer.h"
+#include "chunked_table.h"
 
 class Model;
 class Square;
@@ -44,6 +45,7 @@ class Vision;
 class FieldOfView;
 class Portals;
 class RoofSupport;
+class MemoryReport;
 
 /** A class representing a single level of the dungeon or the overworld. All events occuring on the level are performed by this class.*/
 class Level : public OwnedObject<Level> {
@@ -163,6 +165,7 @@ class Level : public OwnedObject<Level> {
 
   int getNumGeneratedSquares() const;
   int getNumTotalSquares() const;
+  void addMemoryUsage(MemoryReport&) const;
   bool isUnavailable(Vec2) const;
 
   void setNeedsMemoryUpdate(Vec2, bool);
@@ -182,7 +185,7 @@ class Level : public OwnedObject<Level> {
   HeapAllocated<SquareArray> SERIAL(squares);
   HeapAllocated<FurnitureArray> SERIAL(furniture);
   Table<bool> SERIAL(memoryUpdates);
-  Table<bool> renderUpdates = Table<bool>(getMaxBounds(), true);
+  ChunkedTable<bool> renderUpdates = ChunkedTable<bool>(getMaxBounds(), true);
   Table<bool> SERIAL(unavailable);
   unordered_map<StairKey, vector<Position>> SERIAL(landingSquares);
   set<Vec2> SERIAL(tickingSquares);
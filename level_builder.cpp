@@ -11,6 +11,7 @@
 #include "furniture_factory.h"
 #include "position.h"
 #include "movement_set.h"
+#include "level_gen_profiler.h"
 
 LevelBuilder::LevelBuilder(ProgressMeter* meter, RandomGen& r, const CreatureFactory* creatureFactory, int width, int height,
     const string& n, bool allCovered, optional<double> defaultLight)
@@ -19,6 +20,8 @@ LevelBuilder::LevelBuilder(ProgressMeter* meter, RandomGen& r, const CreatureFac
     sunlight(width, height, defaultLight ? *defaultLight : (allCovered ? 0.0 : 1.0)),
     attrib(width, height), items(width, height), furniture(Rectangle(width, height)),
     name(n), progressMeter(meter), random(r), creatureFactory(creatureFactory) {
+  if (LevelGenProfiler::isEnabled())
+    profiler = unique<LevelGenProfiler>(n);
 }
 
 LevelBuilder::LevelBuilder(RandomGen& r, const CreatureFactory* creatureFactory, int width, int height, const string& n, bool covered)
@@ -37,21 +40,25 @@ const CreatureFactory* LevelBuilder::getCreatureFactory() const {
   return creatureFactory;
 }
 
+LevelGenProfiler* LevelBuilder::getProfiler() {
+  return profiler.get();
+}
+
 bool LevelBuilder::hasAttrib(Vec2 posT, SquareAttrib attr) {
   Vec2 pos = transform(posT);
   return attrib[pos].contains(attr);
 }
 
 void LevelBuilder::addAttrib(Vec2 pos, SquareAttrib attr) {
-  attrib[transform(pos)].insert(attr);
+  attrib[transformForWrite(pos)].insert(attr);
 }
 
 void LevelBuilder::removeAttrib(Vec2 pos, SquareAttrib attr) {
-  attrib[transform(pos)].erase(attr);
+  attrib[transformForWrite(pos)].erase(attr);
 }
 
 WSquare LevelBuilder::modSquare(Vec2 pos) {
-  return squares.getWritable(transform(pos));
+  return squares.getWritable(transformForWrite(pos));
 }
 
 Rectangle LevelBuilder::toGlobalCoordinates(Rectangle area) {
@@ -67,8 +74,12 @@ void LevelBuilder::addCollective(CollectiveBuilder* col) {
     collectives.push_back(col);
 }
 
+void LevelBuilder::updateCollective(CollectiveBuilder* col, function<void(CollectiveBuilder*)> update) {
+  collectiveUpdates.emplace_back(col, std::move(update));
+}
+
 void LevelBuilder::setHeightMap(Vec2 pos, double h) {
-  heightMap[transform(pos)] = h;
+  heightMap[transformForWrite(pos)] = h;
 }
 
 double LevelBuilder::getHeightMap(Vec2 pos) {
@@ -76,12 +87,12 @@ double LevelBuilder::getHeightMap(Vec2 pos) {
 }
 
 void LevelBuilder::putCreature(Vec2 pos, PCreature creature) {
-  creatures.emplace_back(std::move(creature), transform(pos));
+  creatures.emplace_back(std::move(creature), transformForWrite(pos));
 }
 
 void LevelBuilder::putItems(Vec2 posT, vector<PItem> it) {
   CHECK(canPutItems(posT));
-  Vec2 pos = transform(posT);
+  Vec2 pos = transformForWrite(posT);
   append(items[pos], std::move(it));
 }
 
@@ -97,7 +108,7 @@ void LevelBuilder::putFurniture(Vec2 posT, FurnitureParams f, optional<SquareAtt
   auto layer = Furniture::getLayer(f.type);
   if (getFurniture(posT, layer))
     removeFurniture(posT, layer);
-  furniture.getBuilt(layer).putElem(transform(posT), f);
+  furniture.getBuilt(layer).putElem(transformForWrite(posT), f);
   if (attrib)
     addAttrib(posT, *attrib);
 }
@@ -124,7 +135,7 @@ bool LevelBuilder::canPutFurniture(Vec2 posT, FurnitureLayer layer) {
 
 void LevelBuilder::removeFurniture(Vec2 pos, FurnitureLayer layer) {
   CHECK(getFurnitureType(pos, layer) != FurnitureType::DOWN_STAIRS);
-  furniture.getBuilt(layer).clearElem(transform(pos));
+  furniture.getBuilt(layer).clearElem(transformForWrite(pos));
 }
 
 void LevelBuilder::removeAllFurniture(Vec2 pos) {
@@ -148,7 +159,7 @@ WConstFurniture LevelBuilder::getFurniture(Vec2 posT, FurnitureLayer layer) {
 }
 
 void LevelBuilder::setLandingLink(Vec2 posT, StairKey key) {
-  Vec2 pos = transform(posT);
+  Vec2 pos = transformForWrite(posT);
   squares.getWritable(pos)->setLandingLink(key);
 }
 
@@ -171,10 +182,12 @@ PLevel LevelBuilder::build(WModel m, LevelMaker* maker, LevelId levelId) {
   PROFILE;
   CHECK(!!m);
   CHECK(mapStack.empty());
-  maker->make(this, squares.getBounds());
+  maker->run(this, squares.getBounds());
   for (Vec2 v : squares.getBounds())
     if (!items[v].empty())
       squares.getWritable(v)->dropItemsLevelGen(std::move(items[v]));
+  for (auto& update : collectiveUpdates)
+    update.second(update.first);
   auto l = Level::create(std::move(squares), std::move(furniture), m, name, sunlight, levelId, covered, unavailable);
   for (pair<PCreature, Vec2>& c : creatures) {
     Position pos(c.second, l.get());
@@ -224,6 +237,60 @@ void LevelBuilder::popMap() {
   mapStack.pop_back();
 }
 
+bool LevelBuilder::isTransformed() const {
+  return !mapStack.empty();
+}
+
+LevelBuilder::Checkpoint LevelBuilder::checkpoint() {
+  PROFILE;
+  vector<FurnitureArray::Array::Snapshot> furnitureSnapshots;
+  for (auto layer : ENUM_ALL(FurnitureLayer))
+    furnitureSnapshots.push_back(furniture.getBuilt(layer).getSnapshot());
+  vector<pair<Vec2, optional<StairKey>>> landingLinks;
+  vector<pair<Vec2, int>> numItems;
+  for (Vec2 v : squares.getBounds()) {
+    if (squares.modified[v])
+      landingLinks.emplace_back(v, squares.modified[v]->getLandingLink());
+    if (!items[v].empty())
+      numItems.emplace_back(v, items[v].size());
+  }
+  return Checkpoint{unavailable, heightMap, covered, building, sunlight, attrib, std::move(furnitureSnapshots),
+      std::move(landingLinks), std::move(numItems), creatures.size(), collectives.size(), collectiveUpdates.size(),
+      mapStack.size(), noDiagonalPassing};
+}
+
+void LevelBuilder::rollback(Checkpoint c) {
+  PROFILE;
+  unavailable = std::move(c.unavailable);
+  heightMap = std::move(c.heightMap);
+  covered = std::move(c.covered);
+  building = std::move(c.building);
+  sunlight = std::move(c.sunlight);
+  attrib = std::move(c.attrib);
+  for (auto layer : ENUM_ALL(FurnitureLayer))
+    furniture.getBuilt(layer).restore(std::move(c.furniture[int(layer)]));
+  // Squares are only modified to set landing links while the level is being built
+  Table<bool> keepSquare(squares.getBounds(), false);
+  for (auto& link : c.landingLinks) {
+    squares.getWritable(link.first)->setLandingLink(link.second);
+    keepSquare[link.first] = true;
+  }
+  Table<int> keepItems(squares.getBounds(), 0);
+  for (auto& elem : c.numItems)
+    keepItems[elem.first] = elem.second;
+  for (Vec2 v : squares.getBounds()) {
+    if (!keepSquare[v])
+      squares.reset(v);
+    if (items[v].size() > keepItems[v])
+      items[v].resize(keepItems[v]);
+  }
+  creatures.resize(c.numCreatures);
+  collectives.resize(c.numCollectives);
+  collectiveUpdates.resize(c.numCollectiveUpdates);
+  mapStack.resize(c.mapDepth);
+  noDiagonalPassing = c.noDiagonalPassing;
+}
+
 Vec2 LevelBuilder::transform(Vec2 v) {
   for (auto m : mapStack.reverse()) {
     v = m(v);
@@ -231,12 +298,18 @@ Vec2 LevelBuilder::transform(Vec2 v) {
   return v;
 }
 
+Vec2 LevelBuilder::transformForWrite(Vec2 v) {
+  if (profiler)
+    profiler->addSquareTouched();
+  return transform(v);
+}
+
 void LevelBuilder::setCovered(Vec2 posT, bool state) {
-  covered[transform(posT)] = state;
+  covered[transformForWrite(posT)] = state;
 }
 
 void LevelBuilder::setBuilding(Vec2 posT, bool state) {
-  building[transform(posT)] = state;
+  building[transformForWrite(posT)] = state;
 }
 
 void LevelBuilder::setSunlight(Vec2 pos, double s) {
@@ -244,7 +317,7 @@ void LevelBuilder::setSunlight(Vec2 pos, double s) {
 }
 
 void LevelBuilder::setUnavailable(Vec2 pos) {
-  unavailable[transform(pos)] = true;
+  unavailable[transformForWrite(pos)] = true;
 }
 
 bool LevelBuilder::canNavigate(Vec2 posT, const MovementType& movement) {
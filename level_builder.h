@@ -12,6 +12,7 @@ class LevelMaker;
 class Square;
 class FurnitureFactory;
 class CollectiveBuilder;
+class LevelGenProfiler;
 
 RICH_ENUM(SquareAttrib,
   NO_DIG,
@@ -106,6 +107,9 @@ class LevelBuilder {
   /** Adds a collective to the level and initializes it.*/
   void addCollective(CollectiveBuilder*);
 
+  /** Changes the collective when the level is built, so that the change can be undone by rollback().*/
+  void updateCollective(CollectiveBuilder*, function<void(CollectiveBuilder*)>);
+
   /** Sets the cover of the square. The value will remain if square is changed.*/
   void setCovered(Vec2, bool state);
 
@@ -123,17 +127,45 @@ class LevelBuilder {
 
   void pushMap(Rectangle bounds, Rot);
   void popMap();
+  bool isTransformed() const;
+
+  struct Checkpoint {
+    Table<bool> unavailable;
+    Table<double> heightMap;
+    Table<bool> covered;
+    Table<bool> building;
+    Table<double> sunlight;
+    Table<EnumSet<SquareAttrib>> attrib;
+    vector<FurnitureArray::Array::Snapshot> furniture;
+    vector<pair<Vec2, optional<StairKey>>> landingLinks;
+    vector<pair<Vec2, int>> numItems;
+    int numCreatures;
+    int numCollectives;
+    int numCollectiveUpdates;
+    int mapDepth;
+    bool noDiagonalPassing;
+  };
+
+  /** Saves the state of the level, so that a failed LevelMaker can be retried without generating
+      the whole level again. The copy costs a few tables of the level's size.*/
+  Checkpoint checkpoint();
+  void rollback(Checkpoint);
 
   RandomGen& getRandom();
   const CreatureFactory* getCreatureFactory() const;
+
+  /** Returns the generation profiler, or null if profiling is disabled.*/
+  LevelGenProfiler* getProfiler();
   
   private:
   Vec2 transform(Vec2);
+  Vec2 transformForWrite(Vec2);
   SquareArray squares;
   Table<bool> unavailable;
   Table<double> heightMap;
   Table<double> dark;
   vector<CollectiveBuilder*> collectives;
+  vector<pair<CollectiveBuilder*, function<void(CollectiveBuilder*)>>> collectiveUpdates;
   Table<bool> covered;
   Table<bool> building;
   Table<double> sunlight;
@@ -147,4 +179,5 @@ class LevelBuilder {
   RandomGen& random;
   bool noDiagonalPassing = false;
   const CreatureFactory* creatureFactory;
+  unique_ptr<LevelGenProfiler> profiler;
 };
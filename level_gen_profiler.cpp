@@ -0,0 +1,143 @@
+#include "stdafx.h"
+#include "level_gen_profiler.h"
+#include "clock.h"
+
+#ifdef __GNUC__
+#include <cxxabi.h>
+#endif
+
+static atomic<bool> enabled(false);
+static std::mutex globalMutex;
+
+void LevelGenProfiler::setEnabled(bool state) {
+  enabled = state;
+}
+
+bool LevelGenProfiler::isEnabled() {
+  return enabled;
+}
+
+// typeid names are mangled on gcc and clang and prefixed with "class " on msvc
+static const string& getMakerName(const char* typeName) {
+  static thread_local unordered_map<const char*, string> cache;
+  auto it = cache.find(typeName);
+  if (it != cache.end())
+    return it->second;
+  string name = typeName;
+#ifdef __GNUC__
+  int status;
+  if (char* demangled = abi::__cxa_demangle(typeName, nullptr, nullptr, &status)) {
+    name = demangled;
+    free(demangled);
+  }
+#endif
+  if (name.substr(0, 6) == "class ")
+    name = name.substr(6);
+  return cache[typeName] = name;
+}
+
+LevelGenProfiler::LevelGenProfiler(const string& levelName) {
+  root.name = levelName;
+  root.numCalls = 1;
+  stack.push_back({&root, 0});
+}
+
+LevelGenProfiler::~LevelGenProfiler() {
+  for (auto& child : root.children)
+    root.micros += child->micros;
+  std::lock_guard<std::mutex> lock(globalMutex);
+  getGlobalRoot().getChild(root.name)->mergeFrom(root);
+}
+
+LevelGenProfiler::Node& LevelGenProfiler::getGlobalRoot() {
+  static Node ret;
+  ret.name = "Level generation";
+  return ret;
+}
+
+LevelGenProfiler::Scope::Scope(LevelGenProfiler* p, const char* makerName) : profiler(p) {
+  if (profiler)
+    profiler->enter(makerName);
+}
+
+LevelGenProfiler::Scope::~Scope() {
+  if (profiler)
+    profiler->exit();
+}
+
+void LevelGenProfiler::enter(const char* makerName) {
+  auto node = stack.back().first->getChild(getMakerName(makerName));
+  ++node->numCalls;
+  stack.push_back({node, Clock::getRealMicros().count()});
+}
+
+void LevelGenProfiler::exit() {
+  CHECK(stack.size() > 1);
+  stack.back().first->micros += Clock::getRealMicros().count() - stack.back().second;
+  stack.pop_back();
+}
+
+void LevelGenProfiler::addSquareTouched() {
+  ++stack.back().first->squaresTouched;
+}
+
+void LevelGenProfiler::addRetry() {
+  ++stack.back().first->retries;
+}
+
+LevelGenProfiler::Node* LevelGenProfiler::Node::getChild(const string& childName) {
+  for (auto& child : children)
+    if (child->name == childName)
+      return child.get();
+  children.push_back(unique<Node>());
+  children.back()->name = childName;
+  return children.back().get();
+}
+
+void LevelGenProfiler::Node::mergeFrom(const Node& other) {
+  numCalls += other.numCalls;
+  micros += other.micros;
+  squaresTouched += other.squaresTouched;
+  retries += other.retries;
+  for (auto& child : other.children)
+    getChild(child->name)->mergeFrom(*child);
+}
+
+void LevelGenProfiler::Node::print(ostream& out, int depth, long long parentMicros) const {
+  long long childMicros = 0;
+  for (auto& child : children)
+    childMicros += child->micros;
+  out << string(2 * depth, ' ') << name << ": " << micros / 1000 << "ms";
+  if (parentMicros > 0)
+    out << " (" << 100 * micros / parentMicros << "%)";
+  out << ", self " << max(0LL, micros - childMicros) / 1000 << "ms, calls " << numCalls
+      << ", squares touched " << squaresTouched << ", retries " << retries << "\n";
+  vector<const Node*> sorted;
+  for (auto& child : children)
+    sorted.push_back(child.get());
+  std::sort(sorted.begin(), sorted.end(), [](const Node* n1, const Node* n2) { return n1->micros > n2->micros; });
+  for (auto child : sorted)
+    child->print(out, depth + 1, micros);
+}
+
+void LevelGenProfiler::printReport(ostream& out) {
+  std::lock_guard<std::mutex> lock(globalMutex);
+  auto& globalRoot = getGlobalRoot();
+  if (globalRoot.children.empty()) {
+    out << "No levels were profiled\n";
+    return;
+  }
+  // The root only groups the levels, its time is the sum of theirs
+  globalRoot.micros = 0;
+  globalRoot.numCalls = 0;
+  for (auto& child : globalRoot.children) {
+    globalRoot.micros += child->micros;
+    globalRoot.numCalls += child->numCalls;
+  }
+  globalRoot.print(out, 0, 0);
+}
+
+void LevelGenProfiler::resetReport() {
+  std::lock_guard<std::mutex> lock(globalMutex);
+  getGlobalRoot().children.clear();
+}
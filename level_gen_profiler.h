@@ -0,0 +1,50 @@
+#pragma once
+
+#include "util.h"
+
+// Statistics of level generation gathered per LevelMaker, as a tree that follows the nesting of makers.
+// Every LevelBuilder records its own tree while profiling is enabled and merges it into a global one
+// when it's destroyed, so levels can be generated on many threads at once.
+class LevelGenProfiler {
+  public:
+  static void setEnabled(bool);
+  static bool isEnabled();
+
+  LevelGenProfiler(const string& levelName);
+  ~LevelGenProfiler();
+
+  class Scope {
+    public:
+    Scope(LevelGenProfiler*, const char* makerName);
+    ~Scope();
+
+    private:
+    LevelGenProfiler* profiler;
+  };
+
+  // Both are attributed to the innermost running maker
+  void addSquareTouched();
+  void addRetry();
+
+  // Prints the tree merged from all builders, children sorted by the time spent in them
+  static void printReport(ostream&);
+  static void resetReport();
+
+  private:
+  struct Node {
+    string name;
+    int numCalls = 0;
+    long long micros = 0;
+    long long squaresTouched = 0;
+    int retries = 0;
+    vector<unique_ptr<Node>> children;
+    Node* getChild(const string& name);
+    void mergeFrom(const Node&);
+    void print(ostream&, int depth, long long parentMicros) const;
+  };
+  static Node& getGlobalRoot();
+  void enter(const char* makerName);
+  void exit();
+  Node root;
+  vector<pair<Node*, long long>> stack;
+};
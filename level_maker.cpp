@@ -38,6 +38,12 @@
 #include "task.h"
 #include "equipment.h"
 #include "creature_group.h"
+#include "level_gen_profiler.h"
+
+void LevelMaker::run(LevelBuilder* builder, Rectangle area) {
+  LevelGenProfiler::Scope scope(builder->getProfiler(), typeid(*this).name());
+  make(builder, area);
+}
 
 namespace {
 
@@ -50,6 +56,11 @@ void checkGen(bool b) {
     failGen();
 }
 
+void addRetry(LevelBuilder* builder) {
+  if (auto profiler = builder->getProfiler())
+    profiler->addRetry();
+}
+
 class Predicate {
   public:
   bool apply(LevelBuilder* builder, Vec2 pos) const {
@@ -66,43 +77,51 @@ class Predicate {
     return builder->getRandom().choose(good);
   }
 
+  // Predicates built from the same factories and operators get equal keys, so their results can be shared.
+  // Predicates without a key are never considered equal.
+  const optional<string>& getKey() const {
+    return key;
+  }
+
   static Predicate attrib(SquareAttrib attr) {
-    return Predicate([=] (LevelBuilder* builder, Vec2 pos) { return builder->hasAttrib(pos, attr);});
+    return Predicate([=] (LevelBuilder* builder, Vec2 pos) { return builder->hasAttrib(pos, attr);},
+        "attrib" + toString(int(attr)));
   }
 
   Predicate operator !() const {
     PredFun self(predFun);
-    return Predicate([self] (LevelBuilder* builder, Vec2 pos) { return !self(builder, pos);});
+    return Predicate([self] (LevelBuilder* builder, Vec2 pos) { return !self(builder, pos);},
+        key.map([](const string& k) { return "!" + k; }));
   }
 
   Predicate operator && (const Predicate& p1) const {
     PredFun self(predFun);
     return Predicate([self, p1] (LevelBuilder* builder, Vec2 pos) {
-        return p1.apply(builder, pos) && self(builder, pos);});
+        return p1.apply(builder, pos) && self(builder, pos);}, combineKeys("&&", p1));
   }
 
   Predicate operator || (const Predicate& p1) const {
     PredFun self(predFun);
     return Predicate([=] (LevelBuilder* builder, Vec2 pos) {
-        return p1.apply(builder, pos) || self(builder, pos);});
+        return p1.apply(builder, pos) || self(builder, pos);}, combineKeys("||", p1));
   }
 
   static Predicate type(FurnitureType t) {
     return Predicate([=] (LevelBuilder* builder, Vec2 pos) {
-      return builder->isFurnitureType(pos, t);});
+      return builder->isFurnitureType(pos, t);}, "type" + toString(int(t)));
   }
 
   static Predicate inRectangle(Rectangle r) {
     return Predicate([=] (LevelBuilder* builder, Vec2 pos) {
-      return pos.inRectangle(r);});
+      return pos.inRectangle(r);}, "rect" + toString(r.topLeft()) + toString(r.bottomRight()));
   }
 
   static Predicate alwaysTrue() {
-    return Predicate([=] (LevelBuilder* builder, Vec2 pos) { return true;});
+    return Predicate([=] (LevelBuilder* builder, Vec2 pos) { return true;}, string("true"));
   }
 
   static Predicate alwaysFalse() {
-    return Predicate([=] (LevelBuilder* builder, Vec2 pos) { return false;});
+    return Predicate([=] (LevelBuilder* builder, Vec2 pos) { return false;}, string("false"));
   }
 
   static Predicate canEnter(MovementType m) {
@@ -111,8 +130,16 @@ class Predicate {
 
   private:
   typedef function<bool(LevelBuilder*, Vec2)> PredFun;
-  Predicate(PredFun fun) : predFun(fun) {}
+  Predicate(PredFun fun, optional<string> key = none) : predFun(fun), key(std::move(key)) {}
+
+  optional<string> combineKeys(const char* op, const Predicate& p1) const {
+    if (key && p1.key)
+      return "(" + *key + op + *p1.key + ")";
+    return none;
+  }
+
   PredFun predFun;
+  optional<string> key;
 };
 
 class SquareChange {
@@ -202,7 +229,8 @@ class SquareChange {
 
   static SquareChange addTerritory(CollectiveBuilder* collective) {
     return SquareChange([=](LevelBuilder* builder, Vec2 pos) {
-      collective->addArea(builder->toGlobalCoordinates(vector<Vec2>({pos})));
+      auto area = builder->toGlobalCoordinates(vector<Vec2>({pos}));
+      builder->updateCollective(collective, [=](CollectiveBuilder* c) { c->addArea(area); });
     });
   }
 
@@ -267,6 +295,8 @@ class RoomMaker : public LevelMaker {
             good = false;
             break;
           }
+        if (!good)
+          addRetry(builder);
       } while (!good && --cnt > 0);
       if (cnt == 0) {
         INFO << "Placed only " << i << " rooms out of " << numRooms;
@@ -289,9 +319,9 @@ class RoomMaker : public LevelMaker {
         wallChange.apply(builder, Vec2(p.x + k.x - 1, i));
       }
       Rectangle inside(p.x + 1, p.y + 1, p.x + k.x - 1, p.y + k.y - 1);
-      roomContents->make(builder, inside);
+      roomContents->run(builder, inside);
       if (i < insideMakers.size())
-        insideMakers[i]->make(builder, inside);
+        insideMakers[i]->run(builder, inside);
       else
         for (Vec2 v : inside)
           builder->addAttrib(v, SquareAttrib::EMPTY_ROOM);
@@ -456,7 +486,8 @@ class Inhabitants : public LevelMaker {
       checkGen(!positions.empty());
       auto pos = builder->getRandom().choose(positions);
       if (collective) {
-        collective->addCreature(creature.get(), minion.second);
+        builder->updateCollective(collective,
+            [c = creature.get(), traits = minion.second](CollectiveBuilder* col) { col->addCreature(c, traits); });
         builder->addCollective(collective);
       }
       builder->putCreature(pos, std::move(creature));
@@ -648,8 +679,9 @@ class MountainRiver : public LevelMaker {
         }
     }
     if (builder->getRandom().roll(predecessor.size()) || ret.empty()) {
+      set<Vec2> lowerTiles(ret.begin(), ret.end());
       for (auto& elem : predecessor)
-        if (!ret.contains(elem.first))
+        if (!lowerTiles.count(elem.first))
           waterTiles.insert(elem.first);
       if (ret.empty())
         return none;
@@ -714,30 +746,42 @@ class Blob : public LevelMaker {
   virtual void addSquare(LevelBuilder* builder, Vec2 pos, int edgeDist) = 0;
 
   virtual void make(LevelBuilder* builder, Rectangle area) override {
-    vector<Vec2> squares;
     Table<char> isInside(area, 0);
     Vec2 center = area.middle();
-    squares.push_back(center);
-    isInside[center] = 1;
-    for (int i : Range(area.width() * area.height() * insideRatio)) {
-      vector<Vec2> nextPos;
-      for (auto pos : squares)
-        for (Vec2 next : pos.neighbors4())
-          if (next.inRectangle(area) && !squares.contains(next))
-            nextPos.push_back(next);
-      vector<double> probs = nextPos.transform([&](Vec2 v) {
-          double px = std::abs(v.x - center.x);
-          double py = std::abs(v.y - center.y);
-          py *= area.width();
-          py /= area.height();
-          double coeff = -1.0 + 1.0 / (sqrt(px * px + py * py) / sqrt(2 * area.width() * area.width()));
-          CHECK(coeff > 0.0);
-          return coeff;
-        });
-      Vec2 chosen = builder->getRandom().choose(nextPos, probs);
-      isInside[chosen] = 1;
-      squares.push_back(chosen);
-    }
+    auto getWeight = [&](Vec2 v) {
+      double px = std::abs(v.x - center.x);
+      double py = std::abs(v.y - center.y);
+      py *= area.width();
+      py /= area.height();
+      double coeff = -1.0 + 1.0 / (sqrt(px * px + py * py) / sqrt(2 * area.width() * area.width()));
+      CHECK(coeff > 0.0);
+      return coeff;
+    };
+    // The candidates are the outside neighbors of every inside square, listed in the order in which the squares
+    // were added, with repetitions. The list is updated incrementally, in the same order as if it was rebuilt
+    // in every step, so that the random choices are the same.
+    vector<Vec2> nextPos;
+    vector<double> probs;
+    auto addInside = [&](Vec2 pos) {
+      isInside[pos] = 1;
+      int numLeft = 0;
+      for (int i : All(nextPos))
+        if (nextPos[i] != pos) {
+          nextPos[numLeft] = nextPos[i];
+          probs[numLeft] = probs[i];
+          ++numLeft;
+        }
+      nextPos.resize(numLeft);
+      probs.resize(numLeft);
+      for (Vec2 next : pos.neighbors4())
+        if (next.inRectangle(area) && !isInside[next]) {
+          nextPos.push_back(next);
+          probs.push_back(getWeight(next));
+        }
+    };
+    addInside(center);
+    for (int i : Range(area.width() * area.height() * insideRatio))
+      addInside(builder->getRandom().choose(nextPos, probs));
     queue<Vec2> q;
     int inf = 10000;
     Table<int> distance(area, inf);
@@ -923,6 +967,8 @@ class Buildings : public LevelMaker {
       int cnt = 10000;
       bool buildingRow;
       do {
+        if (!spaceOk)
+          addRetry(builder);
         buildingRow = builder->getRandom().get(2);
         spaceOk = true;
         w = builder->getRandom().get(minSize, maxSize);
@@ -978,7 +1024,7 @@ class Buildings : public LevelMaker {
         builder->putFurniture(doorLoc, *building.door);
       Rectangle inside(px + 1, py + 1, px + w, py + h);
       if (i < insideMakers.size()) 
-        insideMakers[i]->make(builder, inside);
+        insideMakers[i]->run(builder, inside);
       else
         for (Vec2 v : inside)
           builder->addAttrib(v, SquareAttrib::EMPTY_ROOM);
@@ -1022,7 +1068,7 @@ class MakerQueue : public LevelMaker {
 
   virtual void make(LevelBuilder* builder, Rectangle area) override {
     for (auto& maker : makers)
-      maker->make(builder, area);
+      maker->run(builder, area);
   }
 
   private:
@@ -1053,6 +1099,64 @@ class PredicatePrecalc {
   Table<int> counts;
 };
 
+// Shares summed-area tables between predicates with equal keys.
+class PredicatePrecalcCache {
+  public:
+  PredicatePrecalcCache(LevelBuilder* builder, Rectangle area) : builder(builder), area(area) {}
+
+  const PredicatePrecalc& get(const Predicate& predicate) {
+    if (auto& key = predicate.getKey()) {
+      auto& elem = cached[*key];
+      if (!elem)
+        elem = unique<PredicatePrecalc>(predicate, builder, area);
+      return *elem;
+    }
+    uncached.push_back(unique<PredicatePrecalc>(predicate, builder, area));
+    return *uncached.back();
+  }
+
+  private:
+  LevelBuilder* builder;
+  Rectangle area;
+  map<string, unique_ptr<PredicatePrecalc>> cached;
+  vector<unique_ptr<PredicatePrecalc>> uncached;
+};
+
+// Rectangles bucketed into a coarse grid, so that intersection tests only look at nearby rectangles.
+class OccupancyGrid {
+  public:
+  OccupancyGrid(Rectangle area) : area(area),
+      buckets((area.width() + bucketSize - 1) / bucketSize, (area.height() + bucketSize - 1) / bucketSize) {}
+
+  void add(Rectangle r) {
+    for (Vec2 v : getBuckets(r))
+      buckets[v].push_back(rects.size());
+    rects.push_back(r);
+  }
+
+  bool intersects(Rectangle r) const {
+    for (Vec2 v : getBuckets(r))
+      for (int index : buckets[v])
+        if (rects[index].intersects(r))
+          return true;
+    return false;
+  }
+
+  private:
+  Rectangle getBuckets(Rectangle r) const {
+    if (!r.intersects(area))
+      return Rectangle(0, 0);
+    auto clip = r.intersection(area);
+    return Rectangle((clip.topLeft() - area.topLeft()) / bucketSize,
+        (clip.bottomRight() - area.topLeft() - Vec2(1, 1)) / bucketSize + Vec2(1, 1));
+  }
+
+  static constexpr int bucketSize = 16;
+  Rectangle area;
+  Table<vector<int>> buckets;
+  vector<Rectangle> rects;
+};
+
 class RandomLocations : public LevelMaker {
   public:
   RandomLocations(vector<PLevelMaker> _insideMakers, const vector<pair<int, int>>& _sizes, Predicate pred)
@@ -1072,8 +1176,8 @@ class RandomLocations : public LevelMaker {
 
     class Precomputed {
       public:
-      Precomputed(LevelBuilder* builder, Rectangle area, Predicate p1, Predicate p2, int minSec, int maxSec)
-        : pred1(p1, builder, area), pred2(p2, builder, area), minSecond(minSec), maxSecond(maxSec) {
+      Precomputed(const PredicatePrecalc& p1, const PredicatePrecalc& p2, int minSec, int maxSec)
+        : pred1(p1), pred2(p2), minSecond(minSec), maxSecond(maxSec) {
       }
 
       bool apply(Rectangle rect) const {
@@ -1083,14 +1187,20 @@ class RandomLocations : public LevelMaker {
       }
 
       private:
-      PredicatePrecalc pred1;
-      PredicatePrecalc pred2;
+      const PredicatePrecalc& pred1;
+      const PredicatePrecalc& pred2;
       int minSecond;
       int maxSecond;
     };
 
-    Precomputed precompute(LevelBuilder* builder, Rectangle area) {
-      return Precomputed(builder, area, predicate, second, minSecond, maxSecond);
+    Precomputed precompute(PredicatePrecalcCache& cache) const {
+      return Precomputed(cache.get(predicate), cache.get(second), minSecond, maxSecond);
+    }
+
+    optional<string> getKey() const {
+      if (predicate.getKey() && second.getKey())
+        return *predicate.getKey() + "|" + *second.getKey() + "|" + toString(minSecond) + "|" + toString(maxSecond);
+      return none;
     }
 
     private:
@@ -1143,59 +1253,76 @@ class RandomLocations : public LevelMaker {
 
   virtual void make(LevelBuilder* builder, Rectangle area) override {
     PROFILE;
+    // Makers with equal predicates, sizes and margins share one list of allowed positions.
     vector<vector<Vec2>> allowedPositions;
+    vector<int> positionsIndex;
     vector<LevelBuilder::Rot> rotations;
     {
       PROFILE_BLOCK("precomputing");
+      PredicatePrecalcCache precalcCache(builder, area);
+      map<tuple<string, int, int, int>, int> positionsCache;
       for (int i : All(insideMakers)) {
         rotations.push_back(builder->getRandom().choose(
               LevelBuilder::CW0, LevelBuilder::CW1, LevelBuilder::CW2, LevelBuilder::CW3));
         auto maker = insideMakers[i].get();
-        auto precomputed = predicate[i].precompute(builder, area);
-        vector<Vec2> pos;
         const int margin = getValueMaybe(minMargin, maker).value_or(0);
         int width = sizes[i].first;
         int height = sizes[i].second;
         if (contains({LevelBuilder::CW1, LevelBuilder::CW3}, rotations[i]))
           std::swap(width, height);
+        auto predicateKey = predicate[i].getKey();
+        if (predicateKey)
+          if (auto index = getValueMaybe(positionsCache, make_tuple(*predicateKey, width, height, margin))) {
+            positionsIndex.push_back(*index);
+            continue;
+          }
+        auto precomputed = predicate[i].precompute(precalcCache);
+        vector<Vec2> pos;
         for (int x : Range(area.left() + margin, area.right() - margin - width))
           for (int y : Range(area.top() + margin, area.bottom() - margin - height))
             if (precomputed.apply(Rectangle(x, y, x + width, y + height)))
               pos.push_back(Vec2(x, y));
-        allowedPositions.push_back(pos);
+        if (predicateKey)
+          positionsCache[make_tuple(*predicateKey, width, height, margin)] = allowedPositions.size();
+        positionsIndex.push_back(allowedPositions.size());
+        allowedPositions.push_back(std::move(pos));
       }
     }
     {
       PROFILE_BLOCK("generating positions");
+      // Top level locations retry from a checkpoint when one of the inside makers fails, so that the terrain
+      // around them doesn't have to be generated again.
+      int rollbacksLeft = builder->isTransformed() ? 0 : maxRollbacks;
       for (int i : Range(300))
-        if (tryMake(builder, allowedPositions, rotations))
+        if (tryMake(builder, area, allowedPositions, positionsIndex, rotations, rollbacksLeft))
           return;
+        else
+          addRetry(builder);
       failGen(); // "Failed to find free space for " << (int)sizes.size() << " areas";
     }
   }
 
-  bool checkDistances(int makerIndex, Rectangle area, const vector<Rectangle>& occupied,
-      const vector<optional<double>>& minDist, const vector<optional<double>>& maxDist) {
-    for (int j : Range(makerIndex)) {
-      auto distance = area.getDistance(occupied[j]);
-      if ((maxDist[j] && *maxDist[j] < distance) || (minDist[j] && *minDist[j] > distance))
-        return false;
-    }
-    return true;
-  }
+  struct DistanceLimit {
+    int index;
+    optional<double> minDist;
+    optional<double> maxDist;
+  };
 
-  bool checkIntersections(Rectangle area, const vector<Rectangle>& occupied) {
-    for (Rectangle r : occupied)
-      if (r.intersects(area))
+  bool checkDistances(Rectangle area, const vector<Rectangle>& occupied, const vector<DistanceLimit>& limits) {
+    for (auto& limit : limits) {
+      auto distance = area.getDistance(occupied[limit.index]);
+      if ((limit.maxDist && *limit.maxDist < distance) || (limit.minDist && *limit.minDist > distance))
         return false;
+    }
     return true;
   }
 
-  bool tryMake(LevelBuilder* builder, const vector<vector<Vec2>>& allowedPositions,
-      const vector<LevelBuilder::Rot>& rotations) {
+  bool tryMake(LevelBuilder* builder, Rectangle area, vector<vector<Vec2>>& allowedPositions,
+      const vector<int>& positionsIndex, const vector<LevelBuilder::Rot>& rotations, int& rollbacksLeft) {
     PROFILE;
     vector<Rectangle> occupied;
     vector<Rectangle> makerBounds;
+    OccupancyGrid occupiedGrid(area);
     for (int makerIndex : All(insideMakers)) {
       PROFILE_BLOCK("maker");
       auto maker = insideMakers[makerIndex].get();
@@ -1204,40 +1331,58 @@ class RandomLocations : public LevelMaker {
       int height = sizes[makerIndex].second;
       if (contains({LevelBuilder::CW1, LevelBuilder::CW3}, rotations[makerIndex]))
         std::swap(width, height);
-      vector<optional<double>> maxDist(makerIndex);
-      vector<optional<double>> minDist(makerIndex);
+      vector<DistanceLimit> limits;
       for (int j : Range(makerIndex)) {
-        maxDist[j] = getValueMaybe(maxDistance, make_pair(insideMakers[j].get(), maker));
-        minDist[j] = getValueMaybe(minDistance, make_pair(insideMakers[j].get(), maker));
+        auto maxDist = getValueMaybe(maxDistance, make_pair(insideMakers[j].get(), maker));
+        auto minDist = getValueMaybe(minDistance, make_pair(insideMakers[j].get(), maker));
+        if (maxDist || minDist)
+          limits.push_back({j, minDist, maxDist});
       }
+      // Draws candidates lazily with a partial Fisher-Yates shuffle, so that the whole list is only
+      // shuffled when most of the positions are rejected.
       auto findGoodPosition = [&] () -> optional<Vec2> {
-        for (auto& pos : builder->getRandom().permutation(allowedPositions[makerIndex])) {
+        auto& positions = allowedPositions[positionsIndex[makerIndex]];
+        for (int i : All(positions)) {
+          std::swap(positions[i], positions[i + builder->getRandom().get(positions.size() - i)]);
+          auto& pos = positions[i];
           Progress::checkIfInterrupted();
-          Rectangle area(pos, pos + Vec2(width, height));
-          if ((canOverlap || checkIntersections(area, occupied)) &&
-              checkDistances(makerIndex, area, occupied, minDist, maxDist)) {
+          Rectangle rect(pos, pos + Vec2(width, height));
+          if ((canOverlap || !occupiedGrid.intersects(rect)) && checkDistances(rect, occupied, limits))
             return pos;
-          }
         }
         return none;
       };
       if (auto pos = findGoodPosition()) {
         occupied.push_back(Rectangle(*pos, *pos + Vec2(width, height)));
+        occupiedGrid.add(occupied.back());
         makerBounds.push_back(Rectangle(*pos, *pos + Vec2(sizes[makerIndex].first, sizes[makerIndex].second)));
       } else
         return false;
     }
     CHECK(insideMakers.size() == occupied.size());
-    for (int i : All(insideMakers)) {
-      PROFILE_BLOCK("insider makers");
-      builder->pushMap(makerBounds[i], rotations[i]);
-      insideMakers[i]->make(builder, makerBounds[i]);
-      builder->popMap();
+    optional<LevelBuilder::Checkpoint> checkpoint;
+    if (rollbacksLeft > 0)
+      checkpoint = builder->checkpoint();
+    try {
+      for (int i : All(insideMakers)) {
+        PROFILE_BLOCK("insider makers");
+        builder->pushMap(makerBounds[i], rotations[i]);
+        insideMakers[i]->run(builder, makerBounds[i]);
+        builder->popMap();
+      }
+    } catch (LevelGenException) {
+      if (!checkpoint)
+        throw;
+      INFO << "Rolling back failed locations";
+      --rollbacksLeft;
+      builder->rollback(std::move(*checkpoint));
+      return false;
     }
     return true;
   }
 
   private:
+  static constexpr int maxRollbacks = 5;
   vector<PLevelMaker> insideMakers;
   vector<pair<int, int>> sizes;
   vector<LocationPredicate> predicate;
@@ -1255,7 +1400,7 @@ class Margin : public LevelMaker {
 
   virtual void make(LevelBuilder* builder, Rectangle area) override {
     CHECK(area.width() > left + right && area.height() > top + bottom);
-    inside->make(builder, Rectangle(
+    inside->run(builder, Rectangle(
           area.left() + left,
           area.top() + top,
           area.right() - right,
@@ -1362,15 +1507,20 @@ void raiseLocalMinima(Table<double>& t) {
   }
 }
 
-vector<double> sortedValues(const Table<double>& t) {
+vector<double> getValues(const Table<double>& t) {
   vector<double> values;
-  for (Vec2 v : t.getBounds()) {
+  values.reserve(t.getBounds().area());
+  for (Vec2 v : t.getBounds())
     values.push_back(t[v]);
-  }
-  std::sort(values.begin(), values.end());
   return values;
 }
 
+// Returns the value at the given index in sorted order, without sorting all values
+double getNthValue(vector<double>& values, int index) {
+  std::nth_element(values.begin(), values.begin() + index, values.end());
+  return values[index];
+}
+
 class SetSunlight : public LevelMaker {
   public:
   SetSunlight(double a, Predicate p) : amount(a), pred(p) {}
@@ -1420,10 +1570,11 @@ class Mountains : public LevelMaker {
   virtual void make(LevelBuilder* builder, Rectangle area) override {
     Table<double> wys = genNoiseMap(builder->getRandom(), area, noiseInit, varianceMult);
     raiseLocalMinima(wys);
-    vector<double> values = sortedValues(wys);
-    double cutOffLowland = values[(int)(ratioLowland * double(values.size() - 1))];
-    double cutOffHill = values[(int)((ratioHill + ratioLowland) * double(values.size() - 1))];
-    double cutOffDarkness = values[(int)((ratioHill + ratioLowland + 1.0) * 0.5 * double(values.size() - 1))];
+    vector<double> values = getValues(wys);
+    double cutOffLowland = getNthValue(values, (int)(ratioLowland * double(values.size() - 1)));
+    double cutOffHill = getNthValue(values, (int)((ratioHill + ratioLowland) * double(values.size() - 1)));
+    double cutOffDarkness = getNthValue(values,
+        (int)((ratioHill + ratioLowland + 1.0) * 0.5 * double(values.size() - 1)));
     int dCnt = 0, mCnt = 0, hCnt = 0, lCnt = 0;
     Table<bool> isMountain(area, false);
     for (Vec2 v : area) {
@@ -1560,8 +1711,8 @@ class Forrest : public LevelMaker {
 
   virtual void make(LevelBuilder* builder, Rectangle area) override {
     Table<double> wys = genNoiseMap(builder->getRandom(), area, {0, 0, 0, 0, 0}, 0.65);
-    vector<double> values = sortedValues(wys);
-    double cutoff = values[values.size() * ratio];
+    vector<double> values = getValues(wys);
+    double cutoff = getNthValue(values, (int)(values.size() * ratio));
     for (Vec2 v : area)
       if (builder->isFurnitureType(v, onType) && builder->canNavigate(v, {MovementTrait::WALK}) && wys[v] < cutoff) {
         if (builder->getRandom().getDouble() <= density)
@@ -1583,10 +1734,14 @@ class PlaceCollective : public LevelMaker {
       : collective(NOTNULL(c)), predicate(pred) {}
 
   virtual void make(LevelBuilder* builder, Rectangle area) override {
-    if (!collective->hasCentralPoint())
-      collective->setCentralPoint(builder->toGlobalCoordinates(area).middle());
-    collective->addArea(builder->toGlobalCoordinates(area.getAllSquares()
-        .filter([&](Vec2 pos) { return predicate.apply(builder, pos); })));
+    auto centralPoint = builder->toGlobalCoordinates(area).middle();
+    auto squares = builder->toGlobalCoordinates(area.getAllSquares()
+        .filter([&](Vec2 pos) { return predicate.apply(builder, pos); }));
+    builder->updateCollective(collective, [=](CollectiveBuilder* c) {
+      if (!c->hasCentralPoint())
+        c->setCentralPoint(centralPoint);
+      c->addArea(squares);
+    });
     builder->addCollective(collective);
   }
 
@@ -1718,9 +1873,9 @@ class Division : public LevelMaker {
   void makeHorizDiv(LevelBuilder* builder, Rectangle area) {
     int hDiv = area.left() + min(area.width() - 1, max(1, (int) (hRatio * area.width())));
     if (upperLeft)
-      upperLeft->make(builder, Rectangle(area.left(), area.top(), hDiv, area.bottom()));
+      upperLeft->run(builder, Rectangle(area.left(), area.top(), hDiv, area.bottom()));
     if (upperRight)
-      upperRight->make(builder, Rectangle(hDiv + (wall ? 1 : 0), area.top(), area.right(), area.bottom()));
+      upperRight->run(builder, Rectangle(hDiv + (wall ? 1 : 0), area.top(), area.right(), area.bottom()));
     if (wall)
       for (int i : Range(area.top(), area.bottom()))
         wall->apply(builder, Vec2(hDiv, i));
@@ -1729,9 +1884,9 @@ class Division : public LevelMaker {
   void makeVertDiv(LevelBuilder* builder, Rectangle area) {
     int vDiv = area.top() + min(area.height() - 1, max(1, (int) (vRatio * area.height())));
     if (upperLeft)
-      upperLeft->make(builder, Rectangle(area.left(), area.top(), area.right(), vDiv));
+      upperLeft->run(builder, Rectangle(area.left(), area.top(), area.right(), vDiv));
     if (lowerLeft)
-      lowerLeft->make(builder, Rectangle(area.left(), vDiv + (wall ? 1 : 0), area.right(), area.bottom()));
+      lowerLeft->run(builder, Rectangle(area.left(), vDiv + (wall ? 1 : 0), area.right(), area.bottom()));
     if (wall)
       for (int i : Range(area.left(), area.right()))
         wall->apply(builder, Vec2(i, vDiv));
@@ -1742,13 +1897,13 @@ class Division : public LevelMaker {
     int hDiv = area.left() + min(area.width() - 1, max(1, (int) (hRatio * area.width())));
     int wallSpace = wall ? 1 : 0;
     if (upperLeft)
-      upperLeft->make(builder, Rectangle(area.left(), area.top(), hDiv, vDiv));
+      upperLeft->run(builder, Rectangle(area.left(), area.top(), hDiv, vDiv));
     if (upperRight)
-      upperRight->make(builder, Rectangle(hDiv + wallSpace, area.top(), area.right(), vDiv));
+      upperRight->run(builder, Rectangle(hDiv + wallSpace, area.top(), area.right(), vDiv));
     if (lowerLeft)
-      lowerLeft->make(builder, Rectangle(area.left(), vDiv + wallSpace, hDiv, area.bottom()));
+      lowerLeft->run(builder, Rectangle(area.left(), vDiv + wallSpace, hDiv, area.bottom()));
     if (lowerRight)
-      lowerRight->make(builder, Rectangle(hDiv + wallSpace, vDiv + wallSpace, area.right(), area.bottom()));
+      lowerRight->run(builder, Rectangle(hDiv + wallSpace, vDiv + wallSpace, area.right(), area.bottom()));
     if (wall) {
       for (int i : Range(area.top(), area.bottom()))
         wall->apply(builder, Vec2(hDiv, i));
@@ -1791,9 +1946,9 @@ class AreaCorners : public LevelMaker {
   virtual void make(LevelBuilder* builder, Rectangle area) override {
     vector<Rectangle> corners = builder->getRandom().permutation(getCorners(area));
     for (int i : All(corners)) {
-      maker->make(builder, corners[i]);
+      maker->run(builder, corners[i]);
       if (i < insideMakers.size())
-        insideMakers[i]->make(builder, corners[i]);
+        insideMakers[i]->run(builder, corners[i]);
     }
   }
 
@@ -1870,7 +2025,7 @@ class BorderGuard : public LevelMaker {
       change.apply(builder, Vec2(area.left(), i));
       change.apply(builder, Vec2(area.right() - 1, i));
     }
-    insideMaker->make(builder, Rectangle(area.left() + 1, area.top() + 1, area.right() - 1, area.bottom() - 1));
+    insideMaker->run(builder, Rectangle(area.left() + 1, area.top() + 1, area.right() - 1, area.bottom() - 1));
   }
 
   private:
@@ -2656,7 +2811,7 @@ class SpecificArea : public LevelMaker {
   SpecificArea(Rectangle a, PLevelMaker m) : area(a), maker(std::move(m)) {}
 
   virtual void make(LevelBuilder* builder, Rectangle) override {
-    maker->make(builder, area);
+    maker->run(builder, area);
   }
 
   private:
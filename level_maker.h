@@ -38,6 +38,10 @@ class LevelMaker {
   virtual void make(LevelBuilder* builder, Rectangle area) = 0;
   virtual ~LevelMaker() {}
 
+  /** Calls make(), recording it in the builder's generation profile. Makers should call their
+      inside makers through this.*/
+  void run(LevelBuilder* builder, Rectangle area);
+
   static PLevelMaker cryptLevel(RandomGen&, SettlementInfo);
   static PLevelMaker topLevel(RandomGen&, optional<CreatureGroup> wildlife, vector<SettlementInfo> village, int width,
       optional<TribeId> keeperTribe, BiomeId);
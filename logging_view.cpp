@@ -0,0 +1,8 @@
+#include "stdafx.h"
+#include "logging_view.h"
+#include "fx_renderer.h"
+#include "fx_view_manager.h"
+
+void LoggingView::initialize(unique_ptr<fx::FXRenderer> renderer, unique_ptr<FXViewManager> fxViewManager) {
+  delegate->initialize(std::move(renderer), std::move(fxViewManager));
+}
@@ -0,0 +1,228 @@
+#pragma once
+
+#include "view.h"
+#include "user_input.h"
+
+// Written before each recorded result, so that a replay notices when the game asks for something else
+// than what was recorded.
+enum class ViewCall : std::uint8_t {
+  GAME_SPEED,
+  ACTION,
+  TRAVEL_INTERRUPT,
+  CHOOSE_FROM_LIST,
+  CHOOSE_DIRECTION,
+  CHOOSE_TARGET,
+  YES_OR_NO,
+  NUMBER,
+  TEXT,
+  TRADE_ITEM,
+  PILLAGE_ITEM,
+  ITEM,
+  AT_MOUSE,
+  CREATURE,
+  CREATURE_INFO,
+  SITE,
+  TIME,
+  ABSOLUTE_TIME,
+  CLOCK_STOPPED
+};
+
+// Passes all calls to another view and records the player's input and the time it returns, so that the game
+// can be played again with ReplayView.
+class LoggingView : public View {
+  public:
+  LoggingView(OutputArchive& a, View* d) : archive(a), delegate(d) {}
+
+  virtual void initialize(unique_ptr<fx::FXRenderer>, unique_ptr<FXViewManager>) override;
+
+  virtual void reset() override {
+    delegate->reset();
+  }
+
+  virtual void displaySplash(const ProgressMeter* meter, const string& text, SplashType type,
+      function<void()> cancelFun = nullptr) override {
+    delegate->displaySplash(meter, text, type, cancelFun);
+  }
+
+  virtual void clearSplash() override {
+    delegate->clearSplash();
+  }
+
+  virtual void close() override {
+    delegate->close();
+  }
+
+  virtual void refreshView() override {
+    delegate->refreshView();
+  }
+
+  virtual double getGameSpeed() override {
+    return log(ViewCall::GAME_SPEED, delegate->getGameSpeed());
+  }
+
+  virtual void updateView(CreatureView* creatureView, bool noRefresh) override {
+    delegate->updateView(creatureView, noRefresh);
+  }
+
+  virtual void drawLevelMap(const CreatureView* creatureView) override {
+    delegate->drawLevelMap(creatureView);
+  }
+
+  virtual void setScrollPos(Vec2 pos) override {
+    delegate->setScrollPos(pos);
+  }
+
+  virtual void resetCenter() override {
+    delegate->resetCenter();
+  }
+
+  virtual UserInput getAction() override {
+    return log(ViewCall::ACTION, delegate->getAction());
+  }
+
+  virtual bool travelInterrupt() override {
+    return log(ViewCall::TRAVEL_INTERRUPT, delegate->travelInterrupt());
+  }
+
+  virtual optional<int> chooseFromList(const string& title, const vector<ListElem>& options, int index = 0,
+      MenuType type = MenuType::NORMAL, ScrollPosition* scrollPos = nullptr,
+      optional<UserInputId> exitAction = none) override {
+    return log(ViewCall::CHOOSE_FROM_LIST,
+        delegate->chooseFromList(title, options, index, type, scrollPos, exitAction));
+  }
+
+  virtual optional<Vec2> chooseDirection(Vec2 playerPos, const string& message) override {
+    return log(ViewCall::CHOOSE_DIRECTION, delegate->chooseDirection(playerPos, message));
+  }
+
+  virtual optional<Vec2> chooseTarget(Vec2 playerPos, Table<PassableInfo> passable, const string& message) override {
+    return log(ViewCall::CHOOSE_TARGET, delegate->chooseTarget(playerPos, std::move(passable), message));
+  }
+
+  virtual bool yesOrNoPrompt(const string& message, bool defaultNo = false) override {
+    return log(ViewCall::YES_OR_NO, delegate->yesOrNoPrompt(message, defaultNo));
+  }
+
+  virtual void presentText(const string& title, const string& text) override {
+    delegate->presentText(title, text);
+  }
+
+  virtual void presentList(const string& title, const vector<ListElem>& options, bool scrollDown = false,
+      MenuType type = MenuType::NORMAL, optional<UserInputId> exitAction = none) override {
+    delegate->presentList(title, options, scrollDown, type, exitAction);
+  }
+
+  virtual optional<int> getNumber(const string& title, Range range, int initial, int increments = 1) override {
+    return log(ViewCall::NUMBER, delegate->getNumber(title, range, initial, increments));
+  }
+
+  virtual optional<string> getText(const string& title, const string& value, int maxLength,
+      const string& hint = "") override {
+    return log(ViewCall::TEXT, delegate->getText(title, value, maxLength, hint));
+  }
+
+  virtual optional<UniqueEntity<Item>::Id> chooseTradeItem(const string& title, pair<ViewId, int> budget,
+      const vector<ItemInfo>& items, ScrollPosition* scrollPos) override {
+    return log(ViewCall::TRADE_ITEM, delegate->chooseTradeItem(title, budget, items, scrollPos));
+  }
+
+  virtual optional<int> choosePillageItem(const string& title, const vector<ItemInfo>& items,
+      ScrollPosition* scrollPos) override {
+    return log(ViewCall::PILLAGE_ITEM, delegate->choosePillageItem(title, items, scrollPos));
+  }
+
+  virtual optional<int> chooseItem(const vector<ItemInfo>& items, ScrollPosition* scrollPos) override {
+    return log(ViewCall::ITEM, delegate->chooseItem(items, scrollPos));
+  }
+
+  virtual optional<int> chooseAtMouse(const vector<string>& elems) override {
+    return log(ViewCall::AT_MOUSE, delegate->chooseAtMouse(elems));
+  }
+
+  virtual void presentHighscores(const vector<HighscoreList>& highscores) override {
+    delegate->presentHighscores(highscores);
+  }
+
+  virtual void setBugReportSaveCallback(BugReportSaveCallback callback) override {
+    delegate->setBugReportSaveCallback(callback);
+  }
+
+  // The avatar and the campaign are chosen in the menus, before a recording starts
+  virtual variant<AvatarChoice, AvatarMenuOption> chooseAvatar(const vector<AvatarData>& avatars,
+      Options* options) override {
+    return delegate->chooseAvatar(avatars, options);
+  }
+
+  virtual CampaignAction prepareCampaign(CampaignOptions campaignOptions, Options* options,
+      CampaignMenuState& state) override {
+    return delegate->prepareCampaign(campaignOptions, options, state);
+  }
+
+  virtual optional<UniqueEntity<Creature>::Id> chooseCreature(const string& title,
+      const vector<CreatureInfo>& creatures, const string& cancelText) override {
+    return log(ViewCall::CREATURE, delegate->chooseCreature(title, creatures, cancelText));
+  }
+
+  virtual bool creatureInfo(const string& title, bool prompt, const vector<CreatureInfo>& creatures) override {
+    return log(ViewCall::CREATURE_INFO, delegate->creatureInfo(title, prompt, creatures));
+  }
+
+  virtual optional<Vec2> chooseSite(const string& message, const Campaign& campaign,
+      optional<Vec2> current = none) override {
+    return log(ViewCall::SITE, delegate->chooseSite(message, campaign, current));
+  }
+
+  virtual void presentWorldmap(const Campaign& campaign) override {
+    delegate->presentWorldmap(campaign);
+  }
+
+  virtual void animateObject(Vec2 begin, Vec2 end, optional<ViewId> object, optional<FXInfo> fx) override {
+    delegate->animateObject(begin, end, object, fx);
+  }
+
+  virtual void animation(Vec2 pos, AnimationId id, Dir orientation = Dir::N) override {
+    delegate->animation(pos, id, orientation);
+  }
+
+  virtual void animation(const FXSpawnInfo& info) override {
+    delegate->animation(info);
+  }
+
+  virtual milliseconds getTimeMilli() override {
+    return milliseconds{log(ViewCall::TIME, (long long) delegate->getTimeMilli().count())};
+  }
+
+  virtual milliseconds getTimeMilliAbsolute() override {
+    return milliseconds{log(ViewCall::ABSOLUTE_TIME, (long long) delegate->getTimeMilliAbsolute().count())};
+  }
+
+  virtual void stopClock() override {
+    delegate->stopClock();
+  }
+
+  virtual void continueClock() override {
+    delegate->continueClock();
+  }
+
+  virtual bool isClockStopped() override {
+    return log(ViewCall::CLOCK_STOPPED, delegate->isClockStopped());
+  }
+
+  virtual void addSound(const Sound& sound) override {
+    delegate->addSound(sound);
+  }
+
+  virtual void logMessage(const string& message) override {
+    delegate->logMessage(message);
+  }
+
+  private:
+  template <typename T>
+  T log(ViewCall call, T result) {
+    archive << call << result;
+    return result;
+  }
+
+  OutputArchive& archive;
+  View* delegate;
+};
@@ -40,6 +40,9 @@
 #include "version.h"
 #include "vision.h"
 #include "model_builder.h"
+#include "model.h"
+#include "level_gen_profiler.h"
+#include "object_pool.h"
 #include "sound_library.h"
 #include "audio_device.h"
 #include "sokoban_input.h"
@@ -52,10 +55,13 @@
 #include "creature_factory.h"
 #include "name_generator.h"
 #include "enemy_factory.h"
+#include "thread_pool.h"
+#include "startup_tasks.h"
 
 #include "fx_manager.h"
 #include "fx_renderer.h"
 #include "fx_view_manager.h"
+#include "fx_benchmark.h"
 
 #ifndef VSTUDIO
 #include "stack_printer.h"
@@ -73,12 +79,11 @@
 #define DATA_DIR "."
 #endif
 
-static void initializeRendererTiles(Renderer& r, const DirectoryPath& path) {
+static void addRendererTilesDirectories(Renderer& r, const DirectoryPath& path) {
   r.addTilesDirectory(path.subdirectory("orig16"), Vec2(16, 16));
   r.addTilesDirectory(path.subdirectory("orig24"), Vec2(24, 24));
   r.addTilesDirectory(path.subdirectory("orig30"), Vec2(30, 30));
   r.setAnimationsDirectory(path.subdirectory("animations"));
-  r.loadTiles();
 }
 
 static double getMaxVolume() {
@@ -201,7 +206,17 @@ static po::parser getCommandLineFlags() {
   flags["restore_settings"].description("Restore settings to default values.");
   flags["run_tests"].description("Run all unit tests and exit");
   flags["worldgen_test"].type(po::i32).description("Test how often world generation fails");
+  flags["fx_benchmark"].type(po::i32).description("Measure particle simulation speed over given number of frames");
   flags["worldgen_maps"].type(po::string).description("List of maps or enemy types in world generation test. Skip to test all.");
+  flags["worldgen_json"].type(po::string).description("Write world generation test results as JSON to given file");
+  flags["worldgen_profile"].description("Print time spent in each level maker after the world generation test");
+  flags["worldgen_profile_file"].type(po::string).description("Write the level maker profile of the world generation test to given file");
+  flags["large_map_benchmark"].type(po::i32).description("Generate a map of given width and measure path finding on it");
+  flags["save_benchmark"].type(po::string).description("Measure saving and loading of given saved game");
+  flags["profile"].description("Record timings of profiled functions and show them over the map");
+  flags["profile_trace"].type(po::string).description("Record timings and write them as a Chrome trace to given file on exit");
+  flags["memory_report"].type(po::string).description("Print estimated memory usage of given saved game after loading it");
+  flags["no_object_pool"].description("Allocate creatures, items, furniture and squares with the system allocator");
   flags["battle_level"].type(po::string).description("Path to battle test level");
   flags["battle_info"].type(po::string).description("Path to battle info file");
   flags["battle_enemy"].type(po::string).description("Battle enemy id");
@@ -214,9 +229,14 @@ static po::parser getCommandLineFlags() {
 #ifndef RELEASE
   flags["quick_game"].description("Skip main menu and load the last save file or start a single map game");
 #endif
+  flags["startup_timing"].description("Print the time spent in each loading stage at startup");
   flags["seed"].type(po::i32).description("Use given seed");
   flags["record"].type(po::string).description("Record game to file");
   flags["replay"].type(po::string).description("Replay game from file");
+  flags["replay_benchmark"].type(po::string).description("Replay recorded game without a window as fast as possible and print turn times");
+  flags["replay_budget"].type(po::f64).description("Exit with an error if the P99 turn time in the replay benchmark is over given number of milliseconds");
+  flags["replay_test"].type(po::string).description("Replay recorded game with and without rendering and check that the results are the same");
+  flags["replay_scopes"].type(po::i32).description("Number of most expensive profiled scopes printed by the replay benchmark");
   return flags;
 }
 
@@ -283,6 +303,14 @@ struct AppConfig {
 
 static int keeperMain(po::parser& commandLineFlags) {
   ENABLE_PROFILER;
+  if (commandLineFlags["profile"].was_set() || commandLineFlags["profile_trace"].was_set())
+    Profiler::setEnabled(true);
+  DestructorFunction writeProfilerTrace([&] {
+    if (commandLineFlags["profile_trace"].was_set()) {
+      ofstream out(commandLineFlags["profile_trace"].get().string);
+      Profiler::writeChromeTrace(out);
+    }
+  });
   if (commandLineFlags["help"].was_set()) {
     std::cout << commandLineFlags << endl;
     return 0;
@@ -293,6 +321,10 @@ static int keeperMain(po::parser& commandLineFlags) {
 #else
       commandLineFlags["single_thread"].was_set();
 #endif
+  // Recorded games are only replayed the same way if campaign sites are generated on the main thread
+  if (commandLineFlags["record"].was_set() || commandLineFlags["replay"].was_set() ||
+      commandLineFlags["replay_benchmark"].was_set() || commandLineFlags["replay_test"].was_set())
+    useSingleThread = true;
   FatalLog.addOutput(DebugOutput::crash());
   FatalLog.addOutput(DebugOutput::toStream(std::cerr));
   UserErrorLog.addOutput(DebugOutput::exitProgram());
@@ -308,10 +340,18 @@ static int keeperMain(po::parser& commandLineFlags) {
     InfoLog.addOutput(DebugOutput::toStream(std::cerr));
   Skill::init();
   Spell::init();
+  Model::setNumPathThreads(useSingleThread ? 0 : ThreadPool::getDefaultNumThreads());
+  if (commandLineFlags["no_object_pool"].was_set())
+    ObjectPool::setEnabled(false);
   if (commandLineFlags["run_tests"].was_set()) {
     testAll();
     return 0;
   }
+  if (commandLineFlags["fx_benchmark"].was_set()) {
+    fx::runBenchmark(commandLineFlags["fx_benchmark"].get().i32,
+        useSingleThread ? 0 : ThreadPool::getDefaultNumThreads());
+    return 0;
+  }
   DirectoryPath dataPath([&]() -> string {
     if (commandLineFlags["data_dir"].was_set())
       return commandLineFlags["data_dir"].get().string;
@@ -362,21 +402,6 @@ static int keeperMain(po::parser& commandLineFlags) {
 #endif
   string uploadUrl = appConfig.get<string>("upload_url");
 
-  unique_ptr<fx::FXManager> fxManager;
-  unique_ptr<fx::FXRenderer> fxRenderer;
-  unique_ptr<FXViewManager> fxViewManager;
-
-  if (paidDataPath.exists()) {
-    auto particlesPath = paidDataPath.subdirectory("images").subdirectory("particles");
-    if (particlesPath.exists()) {
-      INFO << "FX: initialization";
-      fxManager = unique<fx::FXManager>();
-      fxRenderer = unique<fx::FXRenderer>(particlesPath, *fxManager);
-      fxRenderer->loadTextures();
-      fxViewManager = unique<FXViewManager>(fxManager.get(), fxRenderer.get());
-    }
-  }
-
   userPath.createIfDoesntExist();
   auto settingsPath = userPath.file("options.txt");
   if (commandLineFlags["restore_settings"].was_set())
@@ -399,7 +424,57 @@ static int keeperMain(po::parser& commandLineFlags) {
   Highscores highscores(userPath.file("highscores.dat"), fileSharing, &options);
   SokobanInput sokobanInput(freeDataPath.file("sokoban_input.txt"), userPath.file("sokoban_state.txt"));
   GameConfig gameConfig(freeDataPath.subdirectory("game_config"));
-  NameGenerator nameGenerator(freeDataPath.subdirectory("names"));
+  bool headless = commandLineFlags["worldgen_test"].was_set() || commandLineFlags["large_map_benchmark"].was_set() ||
+      commandLineFlags["save_benchmark"].was_set() || commandLineFlags["memory_report"].was_set() ||
+      commandLineFlags["replay_benchmark"].was_set() || commandLineFlags["replay_test"].was_set() ||
+      (commandLineFlags["battle_level"].was_set() && !commandLineFlags["battle_view"].was_set());
+  unique_ptr<fx::FXManager> fxManager;
+  unique_ptr<fx::FXRenderer> fxRenderer;
+  unique_ptr<FXViewManager> fxViewManager;
+  unique_ptr<NameGenerator> nameGeneratorPtr;
+  GuiFactory guiFactory(renderer, &clock, &options, &keybindingMap, freeDataPath.subdirectory("images"),
+      tilesPresent ? optional<DirectoryPath>(paidDataPath.subdirectory("images")) : none);
+  {
+    ThreadPool threadPool(useSingleThread ? 0 : ThreadPool::getDefaultNumThreads());
+    StartupTasks startup(threadPool, commandLineFlags["startup_timing"].was_set());
+    // NameGenerator and GuiFactory::loadImages both draw from the main thread's Random, so they have to keep
+    // their order. Worker threads have their own Random, so it's passed explicitly.
+    auto& mainRandom = Random;
+    auto namesTask = startup.addTask("Name lists",
+        [&] { nameGeneratorPtr = unique<NameGenerator>(freeDataPath.subdirectory("names"), mainRandom); });
+    auto particlesPath = paidDataPath.subdirectory("images").subdirectory("particles");
+    if (paidDataPath.exists() && particlesPath.exists()) {
+      auto fxTask = startup.addTask("FX definitions", [&] {
+        INFO << "FX: initialization";
+        fxManager = unique<fx::FXManager>(userPath.file("fx_snapshots.cache"));
+        fxManager->setNumThreads(useSingleThread ? 0 : ThreadPool::getDefaultNumThreads());
+      });
+      startup.addMainThreadTask("FX textures", [&] {
+        fxRenderer = unique<fx::FXRenderer>(particlesPath, *fxManager);
+        fxRenderer->loadTextures();
+        fxViewManager = unique<FXViewManager>(fxManager.get(), fxRenderer.get());
+      }, {fxTask});
+    }
+    if (!headless) {
+      startup.addMainThreadTask("GUI images", [&] { guiFactory.loadImages(); }, {namesTask});
+      if (tilesPresent && !audioError)
+        startup.addTask("Sounds", [&] {
+          soundLibrary = new SoundLibrary(audioDevice, paidDataPath.subdirectory("sound"));
+        });
+      vector<StartupTasks::TaskId> tilesDeps;
+      if (tilesPresent) {
+        addRendererTilesDirectories(renderer, paidDataPath.subdirectory("images"));
+        tilesDeps.push_back(startup.addTask("Tiles and animations", [&] { renderer.decodeTiles(); }));
+      }
+      startup.addMainThreadTask("Tile textures", [&] {
+        if (tilesPresent)
+          renderer.uploadTiles();
+        Tile::initialize(renderer, tilesPresent);
+      }, tilesDeps);
+    }
+    startup.run();
+  }
+  NameGenerator& nameGenerator = *nameGeneratorPtr;
   EnemyFactory enemyFactory(Random, &nameGenerator);
   CreatureFactory creatureFactory(&nameGenerator);
   if (commandLineFlags["worldgen_test"].was_set()) {
@@ -408,9 +483,57 @@ static int keeperMain(po::parser& commandLineFlags) {
     vector<string> types;
     if (commandLineFlags["worldgen_maps"].was_set())
       types = split(commandLineFlags["worldgen_maps"].get().string, {','});
-    loop.modelGenTest(commandLineFlags["worldgen_test"].get().i32, types, Random, &options);
+    optional<FilePath> jsonPath;
+    if (commandLineFlags["worldgen_json"].was_set())
+      jsonPath = FilePath::fromFullPath(commandLineFlags["worldgen_json"].get().string);
+    bool printProfile = commandLineFlags["worldgen_profile"].was_set();
+    bool writeProfile = commandLineFlags["worldgen_profile_file"].was_set();
+    LevelGenProfiler::setEnabled(printProfile || writeProfile);
+    loop.modelGenTest(commandLineFlags["worldgen_test"].get().i32, types, Random, &options, jsonPath);
+    if (printProfile)
+      LevelGenProfiler::printReport(std::cout);
+    if (writeProfile) {
+      ofstream out(commandLineFlags["worldgen_profile_file"].get().string);
+      LevelGenProfiler::printReport(out);
+    }
+    return 0;
+  }
+  if (commandLineFlags["large_map_benchmark"].was_set()) {
+    MainLoop loop(nullptr, &highscores, &fileSharing, freeDataPath, userPath, &options, &jukebox, &sokobanInput,
+        &gameConfig, &creatureFactory, &nameGenerator, &enemyFactory, useSingleThread, 0);
+    loop.largeMapBenchmark(commandLineFlags["large_map_benchmark"].get().i32, 200, Random);
+    return 0;
+  }
+  if (commandLineFlags["save_benchmark"].was_set()) {
+    MainLoop loop(nullptr, &highscores, &fileSharing, freeDataPath, userPath, &options, &jukebox, &sokobanInput,
+        &gameConfig, &creatureFactory, &nameGenerator, &enemyFactory, useSingleThread, 0);
+    loop.saveBenchmark(FilePath::fromFullPath(commandLineFlags["save_benchmark"].get().string), 5);
+    return 0;
+  }
+  if (commandLineFlags["memory_report"].was_set()) {
+    MainLoop loop(nullptr, &highscores, &fileSharing, freeDataPath, userPath, &options, &jukebox, &sokobanInput,
+        &gameConfig, &creatureFactory, &nameGenerator, &enemyFactory, useSingleThread, 0);
+    loop.memoryReport(FilePath::fromFullPath(commandLineFlags["memory_report"].get().string));
     return 0;
   }
+  if (commandLineFlags["replay_benchmark"].was_set()) {
+    MainLoop loop(nullptr, &highscores, &fileSharing, freeDataPath, userPath, &options, &jukebox, &sokobanInput,
+        &gameConfig, &creatureFactory, &nameGenerator, &enemyFactory, useSingleThread,
+        appConfig.get<int>("save_version"));
+    optional<double> budget;
+    if (commandLineFlags["replay_budget"].was_set())
+      budget = commandLineFlags["replay_budget"].get().f64;
+    int numScopes = commandLineFlags["replay_scopes"].was_set() ? commandLineFlags["replay_scopes"].get().i32 : 20;
+    bool withinBudget = loop.replayBenchmark(FilePath::fromFullPath(commandLineFlags["replay_benchmark"].get().string),
+        budget, numScopes);
+    return withinBudget ? 0 : 1;
+  }
+  if (commandLineFlags["replay_test"].was_set()) {
+    MainLoop loop(nullptr, &highscores, &fileSharing, freeDataPath, userPath, &options, &jukebox, &sokobanInput,
+        &gameConfig, &creatureFactory, &nameGenerator, &enemyFactory, useSingleThread,
+        appConfig.get<int>("save_version"));
+    return loop.replayTest(FilePath::fromFullPath(commandLineFlags["replay_test"].get().string)) ? 0 : 1;
+  }
   auto battleTest = [&] (View* view) {
     MainLoop loop(view, &highscores, &fileSharing, freeDataPath, userPath, &options, &jukebox, &sokobanInput,
         &gameConfig, &creatureFactory, &nameGenerator, &enemyFactory, useSingleThread, 0);
@@ -434,22 +557,13 @@ static int keeperMain(po::parser& commandLineFlags) {
     battleTest(new DummyView(&clock));
     return 0;
   }
-  GuiFactory guiFactory(renderer, &clock, &options, &keybindingMap, freeDataPath.subdirectory("images"),
-      tilesPresent ? optional<DirectoryPath>(paidDataPath.subdirectory("images")) : none);
-  guiFactory.loadImages();
-  if (tilesPresent) {
-    if (!audioError) {
-      soundLibrary = new SoundLibrary(audioDevice, paidDataPath.subdirectory("sound"));
-      options.addTrigger(OptionId::SOUND, [soundLibrary](int volume) {
-        soundLibrary->setVolume(volume);
-        soundLibrary->playSound(SoundId::SPELL_DECEPTION);
-      });
-      soundLibrary->setVolume(options.getIntValue(OptionId::SOUND));
-    }
+  if (soundLibrary) {
+    options.addTrigger(OptionId::SOUND, [soundLibrary](int volume) {
+      soundLibrary->setVolume(volume);
+      soundLibrary->playSound(SoundId::SPELL_DECEPTION);
+    });
+    soundLibrary->setVolume(options.getIntValue(OptionId::SOUND));
   }
-  if (tilesPresent)
-    initializeRendererTiles(renderer, paidDataPath.subdirectory("images"));
-  Tile::initialize(renderer, tilesPresent);
   FileSharing bugreportSharing("http://retired.keeperrl.com/~bugreports", options, installId);
   unique_ptr<View> view;
   view.reset(WindowView::createDefaultView(
@@ -470,7 +584,12 @@ static int keeperMain(po::parser& commandLineFlags) {
     ofstream systemInfo(userPath.file("system_info.txt").getPath());
     systemInfo << "KeeperRL version " << BUILD_VERSION << " " << BUILD_DATE << std::endl;
     renderer.printSystemInfo(systemInfo);
-    loop.start(tilesPresent, commandLineFlags["quick_game"].was_set());
+    if (commandLineFlags["record"].was_set())
+      loop.setRecording(FilePath::fromFullPath(commandLineFlags["record"].get().string));
+    if (commandLineFlags["replay"].was_set())
+      loop.replay(FilePath::fromFullPath(commandLineFlags["replay"].get().string));
+    else
+      loop.start(tilesPresent, commandLineFlags["quick_game"].was_set());
   } catch (GameExitException ex) {
   }
   jukebox.toggle(false);
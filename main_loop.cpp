@@ -36,15 +36,37 @@
 #include "game_config.h"
 #include "avatar_menu_option.h"
 #include "creature_name.h"
+#include "thread_pool.h"
+#include "tribe_alignment.h"
+#include "level.h"
+#include "shortest_path.h"
+#include "movement_type.h"
+#include "object_pool.h"
+#include "memory_report.h"
+#include "dummy_view.h"
+#include "replay_view.h"
+#include "creature_view.h"
+#include "game_info.h"
+#include "view_index.h"
+
+// Site names don't depend on the seed of the running process, so a site that is generated again after the game
+// was loaded in another process gets the same names. Every site draws from its own copy, see withSiteModelBuilder.
+static unique_ptr<NameGenerator> getSiteNameGenerator(const DirectoryPath& dataPath) {
+  RandomGen random(1);
+  return unique<NameGenerator>(dataPath.subdirectory("names"), random);
+}
 
 MainLoop::MainLoop(View* v, Highscores* h, FileSharing* fSharing, const DirectoryPath& freePath,
     const DirectoryPath& uPath, Options* o, Jukebox* j, SokobanInput* soko, GameConfig* gameConfig,
     const CreatureFactory* creatureFactory, NameGenerator* n, const EnemyFactory* e, bool singleThread, int sv)
       : view(v), dataFreePath(freePath), userPath(uPath), options(o), jukebox(j), highscores(h), fileSharing(fSharing),
         gameConfig(gameConfig), useSingleThread(singleThread), sokobanInput(soko), saveVersion(sv),
-        creatureFactory(creatureFactory), nameGenerator(n), enemyFactory(e) {
+        creatureFactory(creatureFactory), nameGenerator(n), enemyFactory(e),
+        siteNameGenerator(getSiteNameGenerator(freePath)) {
 }
 
+MainLoop::~MainLoop() {}
+
 vector<SaveFileInfo> MainLoop::getSaveFiles(const DirectoryPath& path, const string& suffix) {
   vector<SaveFileInfo> ret;
   for (auto file : path.getFiles()) {
@@ -106,19 +128,23 @@ static string stripFilename(string s) {
 }
 
 void MainLoop::saveGame(PGame& game, const FilePath& path) {
-  CompressedOutput out(path.getPath());
-  string name = game->getGameDisplayName();
-  SavedGameInfo savedInfo = game->getSavedGameInfo();
-  out.getArchive() << saveVersion << name << savedInfo;
-  out.getArchive() << game;
+  SaveFileHeader header{saveVersion, game->getGameDisplayName(), game->getSavedGameInfo()};
+  {
+    CompressedOutput out(path.getPath());
+    out.getArchive() << header.version << header.name << header.info;
+    Game::save(out.getArchive(), game);
+  }
+  writeSaveHeader(path, header);
 }
 
 void MainLoop::saveMainModel(PGame& game, const FilePath& path) {
-  CompressedOutput out(path.getPath());
-  string name = game->getGameDisplayName();
-  SavedGameInfo savedInfo = game->getSavedGameInfo();
-  out.getArchive() << saveVersion << name << savedInfo;
-  out.getArchive() << game->getMainModel();
+  SaveFileHeader header{saveVersion, game->getGameDisplayName(), game->getSavedGameInfo()};
+  {
+    CompressedOutput out(path.getPath());
+    out.getArchive() << header.version << header.name << header.info;
+    out.getArchive() << game->getMainModel();
+  }
+  writeSaveHeader(path, header);
 }
 
 void MainLoop::reloadModel(const FilePath& path) {
@@ -131,8 +157,8 @@ void MainLoop::reloadModel(const FilePath& path) {
 }
 
 int MainLoop::getSaveVersion(const SaveFileInfo& save) {
-  if (auto info = getNameAndVersion(userPath.file(save.filename)))
-    return info->second;
+  if (auto header = getSaveHeader(userPath.file(save.filename)))
+    return header->version;
   else
     return -1;
 }
@@ -177,7 +203,9 @@ void MainLoop::saveUI(PGame& game, GameSaveType type, SplashType splashType) {
 }
 
 void MainLoop::eraseSaveFile(const PGame& game, GameSaveType type) {
-  remove(getSavePath(game, type).getPath());
+  auto path = getSavePath(game, type);
+  remove(path.getPath());
+  remove(getSaveHeaderPath(path).getPath());
 }
 
 void MainLoop::getSaveOptions(const vector<pair<GameSaveType, string>>& games, vector<ListElem>& options,
@@ -190,8 +218,8 @@ void MainLoop::getSaveOptions(const vector<pair<GameSaveType, string>>& games, v
       options.emplace_back(elem.second, ListElem::TITLE);
       append(options, files.transform(
           [this] (const SaveFileInfo& info) {
-              auto nameAndVersion = getNameAndVersion(userPath.file(info.filename));
-              return ListElem(nameAndVersion->first, getDateString(info.date));}));
+              auto header = getSaveHeader(userPath.file(info.filename));
+              return ListElem(header->name, getDateString(info.date));}));
     }
   }
 }
@@ -229,13 +257,64 @@ void MainLoop::bugReportSave(PGame& game, FilePath path) {
   Square::progressMeter = nullptr;
 }
 
+void MainLoop::setRecording(const FilePath& path) {
+  recordingPath = path;
+}
+
+static string saveToString(PGame& game) {
+  std::stringstream stream;
+  {
+    OutputArchive archive(stream);
+    Game::save(archive, game);
+  }
+  return stream.str();
+}
+
+static PGame loadFromString(const string& data) {
+  std::stringstream stream(data);
+  InputArchive archive(stream);
+  PGame ret;
+  archive >> ret;
+  return ret;
+}
+
+PGame MainLoop::loadRecording(InputArchive& archive) {
+  int version;
+  int seed;
+  string data;
+  archive >> version >> seed >> data;
+  USER_CHECK(version == saveVersion) << "The recording was made with a different version of the game";
+  auto game = loadFromString(data);
+  Random.init(seed);
+  return game;
+}
+
 MainLoop::ExitCondition MainLoop::playGame(PGame game, bool withMusic, bool noAutoSave,
     function<optional<ExitCondition>(WGame)> exitCondition, milliseconds stepTimeMilli) {
+  unique_ptr<CompressedOutput> recording;
+  unique_ptr<LoggingView> loggingView;
+  View* liveView = view;
+  // Only games played by the player are recorded, not the splash screen and the tests. The recording starts
+  // from a saved and loaded copy of the game, and with a new seed, just like a replay does.
+  if (recordingPath && !noAutoSave) {
+    auto data = saveToString(game);
+    game = loadFromString(data);
+    int seed = Random.get(INT_MAX);
+    Random.init(seed);
+    recording = unique<CompressedOutput>(recordingPath->getPath());
+    recording->getArchive() << saveVersion << seed << data;
+    loggingView = unique<LoggingView>(recording->getArchive(), view);
+    view = loggingView.get();
+  }
+  DestructorFunction restoreView([&] { view = liveView; });
   view->reset();
   if (!noAutoSave)
     view->setBugReportSaveCallback([&] (FilePath path) { bugReportSave(game, path); });
   DestructorFunction removeCallback([&] { view->setBugReportSaveCallback(nullptr); });
   game->initialize(options, highscores, view, fileSharing, gameConfig, creatureFactory);
+  game->setSiteGenerator([this] (EnemyId enemyId, VillainType type, TribeAlignment alignment, int seed) {
+        return generateVillainSite(enemyId, type, alignment, seed);
+      }, !useSingleThread);
   Intervalometer meter(stepTimeMilli);
   auto lastMusicUpdate = GlobalTime(-1000);
   auto lastAutoSave = game->getGlobalTime();
@@ -282,6 +361,7 @@ MainLoop::ExitCondition MainLoop::playGame(PGame game, bool withMusic, bool noAu
       lastAutoSave = gameTime;
     }
     view->refreshView();
+    Profiler::markEnd(ProfilerPeriod::FRAME);
   }
 }
 
@@ -297,8 +377,8 @@ optional<RetiredGames> MainLoop::getRetiredGames(CampaignType type) {
       RetiredGames ret;
       for (auto& info : getSaveFiles(userPath, getSaveSuffix(GameSaveType::RETIRED_SITE)))
         if (isCompatible(getSaveVersion(info)))
-          if (auto saved = getSavedGameInfo(userPath.file(info.filename)))
-            ret.addLocal(*saved, info);
+          if (auto header = getSaveHeader(userPath.file(info.filename)))
+            ret.addLocal(header->info, info);
       optional<vector<FileSharing::SiteInfo>> onlineSites;
       doWithSplash(SplashType::SMALL, "Fetching list of retired dungeons from the server...",
           [&] { onlineSites = fileSharing->listSites(); }, [&] { fileSharing->cancel(); });
@@ -315,8 +395,8 @@ optional<RetiredGames> MainLoop::getRetiredGames(CampaignType type) {
       RetiredGames ret;
       for (auto& info : getSaveFiles(userPath, getSaveSuffix(GameSaveType::RETIRED_CAMPAIGN)))
         if (isCompatible(getSaveVersion(info)))
-          if (auto saved = getSavedGameInfo(userPath.file(info.filename)))
-            ret.addLocal(*saved, info);
+          if (auto header = getSaveHeader(userPath.file(info.filename)))
+            ret.addLocal(header->info, info);
       for (int i : All(ret.getAllGames()))
         ret.setActive(i, true);
       return ret;
@@ -469,6 +549,17 @@ void MainLoop::start(bool tilesPresent, bool quickGame) {
   }
 }
 
+// The caller waits for the thread to finish, so the thread takes over the caller's random sequence
+// and gives it back at the end, as if everything was run on the calling thread.
+static function<void()> continueCallerRandom(function<void()> fun) {
+  RandomGen* callerRandom = &Random;
+  return [callerRandom, fun] {
+    Random = *callerRandom;
+    OnExit tmp([callerRandom] { *callerRandom = Random; });
+    fun();
+  };
+}
+
 #ifdef OSX // see thread comment in stdafx.h
 static thread::attributes getAttributes() {
   thread::attributes attr;
@@ -477,13 +568,13 @@ static thread::attributes getAttributes() {
 }
 
 static thread makeThread(function<void()> fun) {
-  return thread(getAttributes(), fun);
+  return thread(getAttributes(), continueCallerRandom(fun));
 }
 
 #else
 
 static thread makeThread(function<void()> fun) {
-  return thread(fun);
+  return thread(continueCallerRandom(fun));
 }
 
 #endif
@@ -523,9 +614,278 @@ void MainLoop::doWithSplash(SplashType type, const string& text, function<void()
   }
 }
 
-void MainLoop::modelGenTest(int numTries, const vector<string>& types, RandomGen& random, Options* options) {
-  ProgressMeter meter(1);
-  ModelBuilder(&meter, random, options, sokobanInput, gameConfig, creatureFactory, enemyFactory).measureSiteGen(numTries, types);
+// Nearest-rank percentile
+static int getPercentile(const vector<int>& sorted, int percent) {
+  return sorted[max<int>(0, (sorted.size() * percent + 99) / 100 - 1)];
+}
+
+void MainLoop::modelGenTest(int numTries, const vector<string>& types, RandomGen& random, Options* options,
+    optional<FilePath> jsonPath) {
+  auto cases = ModelBuilder(nullptr, random, options, sokobanInput, gameConfig, creatureFactory, enemyFactory)
+      .getSiteGenCases(types);
+  if (!cases || numTries < 1)
+    return;
+  // Every try has its own seed, so the results don't depend on the number of threads
+  int numJobs = cases->size() * numTries;
+  vector<int> seeds(numJobs);
+  for (auto& seed : seeds)
+    seed = random.get(INT_MAX);
+  vector<int> millis(numJobs);
+  vector<char> success(numJobs);
+  ThreadPool threadPool(useSingleThread ? 0 : ThreadPool::getDefaultNumThreads());
+  auto startTime = Clock::getRealMicros();
+  threadPool.forEach(numJobs, [&] (int job) {
+    auto& genCase = (*cases)[job / numTries];
+    withSiteModelBuilder(seeds[job], [&] (ModelBuilder& modelBuilder) {
+      auto time = Clock::getRealMicros();
+      success[job] = modelBuilder.trySiteGen(genCase);
+      millis[job] = (Clock::getRealMicros() - time).count() / 1000;
+    });
+  });
+  auto totalMillis = (Clock::getRealMicros() - startTime).count() / 1000;
+  std::cout << cases->size() << " cases, " << numTries << " tries each, " << threadPool.getNumThreads()
+      << " threads, total time: " << totalMillis << "ms" << std::endl;
+  optional<ofstream> json;
+  if (jsonPath) {
+    json.emplace(jsonPath->getPath());
+    *json << "{\n  \"tries\": " << numTries << ",\n  \"threads\": " << threadPool.getNumThreads()
+        << ",\n  \"total_ms\": " << totalMillis << ",\n  \"cases\": [";
+  }
+  for (int caseIndex : All(*cases)) {
+    auto& genCase = (*cases)[caseIndex];
+    vector<int> times(millis.begin() + caseIndex * numTries, millis.begin() + (caseIndex + 1) * numTries);
+    std::sort(times.begin(), times.end());
+    int numFailures = std::count(success.begin() + caseIndex * numTries,
+        success.begin() + (caseIndex + 1) * numTries, 0);
+    double avg = double(std::accumulate(times.begin(), times.end(), 0)) / numTries;
+    string alignment = genCase.alignment ? EnumInfo<TribeAlignment>::getString(*genCase.alignment) : "";
+    std::cout << genCase.type << " " << alignment << ": " << numTries - numFailures << " / " << numTries
+        << " (" << 100.0 * numFailures / numTries << "% failed). MinT: " << times.front()
+        << " P50: " << getPercentile(times, 50) << " P90: " << getPercentile(times, 90)
+        << " P99: " << getPercentile(times, 99) << " MaxT: " << times.back() << " AvgT: " << avg << std::endl;
+    if (json)
+      *json << (caseIndex > 0 ? "," : "") << "\n    {\"type\": \"" << genCase.type << "\", \"alignment\": \""
+          << alignment << "\", \"failures\": " << numFailures << ", \"min_ms\": " << times.front()
+          << ", \"p50_ms\": " << getPercentile(times, 50) << ", \"p90_ms\": " << getPercentile(times, 90)
+          << ", \"p99_ms\": " << getPercentile(times, 99) << ", \"max_ms\": " << times.back()
+          << ", \"avg_ms\": " << avg << "}";
+  }
+  if (json) {
+    *json << "\n  ]\n}\n";
+    if (!*json)
+      std::cout << "Failed to write " << *jsonPath << std::endl;
+  }
+}
+
+void MainLoop::largeMapBenchmark(int width, int numPaths, RandomGen& random) {
+  withSiteModelBuilder(random.get(INT_MAX), [&] (ModelBuilder& modelBuilder) {
+    auto startTime = Clock::getRealMicros();
+    auto model = modelBuilder.largeMapModel(width);
+    std::cout << "Generated " << width << "x" << width << " map in "
+        << (Clock::getRealMicros() - startTime).count() / 1000 << "ms" << std::endl;
+    auto level = model->getTopLevel();
+    auto walkers = level->getAllCreatures().filter(
+        [](WConstCreature c) { return c->getMovementType().hasTrait(MovementTrait::WALK); });
+    if (walkers.empty() || numPaths < 1) {
+      std::cout << "No paths to measure" << std::endl;
+      return;
+    }
+    vector<int> micros;
+    int numReachable = 0;
+    for (int i : Range(numPaths)) {
+      auto creature = random.choose(walkers);
+      auto target = Position(Vec2(random.get(level->getBounds().width()), random.get(level->getBounds().height())),
+          level);
+      auto time = Clock::getRealMicros();
+      LevelShortestPath path(creature, target, creature->getPosition());
+      micros.push_back((Clock::getRealMicros() - time).count());
+      if (path.isReachable(creature->getPosition()))
+        ++numReachable;
+    }
+    std::sort(micros.begin(), micros.end());
+    std::cout << numPaths << " paths, " << numReachable << " reachable. P50: " << getPercentile(micros, 50)
+        << "us P90: " << getPercentile(micros, 90) << "us P99: " << getPercentile(micros, 99) << "us MaxT: "
+        << micros.back() << "us" << std::endl;
+  });
+}
+
+void MainLoop::saveBenchmark(const FilePath& path, int numTries) {
+  auto game = loadFromFile<PGame>(path, false);
+  for (bool bulk : {false, true}) {
+    setBulkSerialization(bulk);
+    long long saveMicros = 0;
+    long long loadMicros = 0;
+    size_t size = 0;
+    long long numLoadAllocations = 0;
+    long long numLoadHeapAllocations = 0;
+    for (int i : Range(numTries)) {
+      std::stringstream stream;
+      auto time = Clock::getRealMicros();
+      {
+        OutputArchive archive(stream);
+        Game::save(archive, game);
+      }
+      saveMicros += (Clock::getRealMicros() - time).count();
+      size = stream.str().size();
+      time = Clock::getRealMicros();
+      auto allocations = ObjectPool::getNumAllocations();
+      auto heapAllocations = ObjectPool::getNumHeapAllocations();
+      {
+        PGame loaded;
+        InputArchive archive(stream);
+        archive >> loaded;
+        loadMicros += (Clock::getRealMicros() - time).count();
+      }
+      numLoadAllocations = ObjectPool::getNumAllocations() - allocations;
+      numLoadHeapAllocations = ObjectPool::getNumHeapAllocations() - heapAllocations;
+    }
+    std::cout << (bulk ? "Bulk tables: " : "Element by element: ") << "save " << saveMicros / numTries / 1000
+        << "ms, load " << loadMicros / numTries / 1000 << "ms, size " << size / 1024 << "KB, objects allocated on load "
+        << numLoadAllocations << ", heap allocations " << numLoadHeapAllocations
+        << (ObjectPool::isEnabled() ? "" : " (object pool disabled)") << std::endl;
+  }
+  setBulkSerialization(true);
+}
+
+void MainLoop::memoryReport(const FilePath& path) {
+  auto game = loadFromFile<PGame>(path, false);
+  MemoryReport report("Game");
+  game->addMemoryUsage(report);
+  report.print(std::cout, 4);
+}
+
+void MainLoop::replay(const FilePath& path) {
+  CompressedInput input(path.getPath());
+  auto game = loadRecording(input.getArchive());
+  ReplayView replayView(input.getArchive(), view, false);
+  View* liveView = view;
+  view = &replayView;
+  DestructorFunction restoreView([&] { view = liveView; });
+  playGame(std::move(game), true, true);
+}
+
+namespace {
+// Asks the game for everything that the window shows in a frame, several times per update like a window that
+// renders faster than the game runs, but doesn't draw anything.
+class RenderingTestView : public DummyView {
+  public:
+  using DummyView::DummyView;
+
+  virtual void updateView(CreatureView* view, bool noRefresh) override {
+    for (int frame : Range(3)) {
+      GameInfo info;
+      view->refreshGameInfo(info);
+      if (auto level = view->getLevel()) {
+        for (Vec2 v : level->getBounds()) {
+          ViewIndex index;
+          view->getViewIndex(v, index);
+        }
+        view->getUnknownLocations(level);
+      }
+      view->getVisibleEnemies();
+      view->getAnimationTime();
+    }
+  }
+};
+}
+
+string MainLoop::replayResult(const FilePath& path, View* delegate, bool withMusic) {
+  CompressedInput input(path.getPath());
+  auto game = loadRecording(input.getArchive());
+  ReplayView replayView(input.getArchive(), delegate, true);
+  View* liveView = view;
+  view = &replayView;
+  DestructorFunction restoreView([&] { view = liveView; });
+  string ret;
+  playGame(std::move(game), withMusic, true, [&] (WGame game) -> optional<ExitCondition> {
+    if (!replayView.isFinished())
+      return none;
+    ret = "turn " + toString(game->getGlobalTime().getVisibleInt()) + ", next random number " +
+        toString(Random.getLL());
+    return ExitCondition::UNKNOWN;
+  });
+  return ret;
+}
+
+bool MainLoop::replayTest(const FilePath& path) {
+  Clock clock;
+  RenderingTestView renderingView(&clock);
+  auto rendered = replayResult(path, &renderingView, true);
+  DummyView dummyView(&clock);
+  auto notRendered = replayResult(path, &dummyView, false);
+  if (rendered != notRendered) {
+    std::cout << "Replay depends on the view. With rendering: " << rendered << ". Without: " << notRendered
+        << std::endl;
+    return false;
+  }
+  std::cout << "Replay is the same with and without rendering: " << rendered << std::endl;
+  return true;
+}
+
+bool MainLoop::replayBenchmark(const FilePath& path, optional<double> maxTurnMillis, int numScopes) {
+  CompressedInput input(path.getPath());
+  auto game = loadRecording(input.getArchive());
+  Clock clock;
+  DummyView dummyView(&clock);
+  ReplayView replayView(input.getArchive(), &dummyView, true);
+  View* liveView = view;
+  view = &replayView;
+  DestructorFunction restoreView([&] { view = liveView; });
+  Profiler::setEnabled(true);
+  Profiler::markEnd(ProfilerPeriod::FRAME);
+  vector<int> turnMicros;
+  std::unordered_map<string, Profiler::Entry> scopes;
+  long long numDropped = 0;
+  auto startTime = Clock::getRealMicros();
+  auto turnStartTime = startTime;
+  auto lastTurn = game->getGlobalTime();
+  playGame(std::move(game), false, true, [&] (WGame game) -> optional<ExitCondition> {
+    // The summary is of the previous frame, which ended after the previous call
+    auto summary = Profiler::getLastSummary(ProfilerPeriod::FRAME);
+    for (auto& entry : summary.entries) {
+      auto& scope = scopes[entry.name];
+      scope.name = entry.name;
+      scope.numCalls += entry.numCalls;
+      scope.micros += entry.micros;
+    }
+    numDropped += summary.numDropped;
+    auto turn = game->getGlobalTime();
+    if (lastTurn < turn) {
+      auto time = Clock::getRealMicros();
+      turnMicros.push_back((time - turnStartTime).count());
+      turnStartTime = time;
+      lastTurn = turn;
+    }
+    if (replayView.isFinished())
+      return ExitCondition::UNKNOWN;
+    return none;
+  });
+  auto totalMicros = (Clock::getRealMicros() - startTime).count();
+  if (turnMicros.empty()) {
+    std::cout << "No turns were replayed" << std::endl;
+    return true;
+  }
+  std::sort(turnMicros.begin(), turnMicros.end());
+  std::cout << turnMicros.size() << " turns in " << totalMicros / 1000 << "ms, "
+      << turnMicros.size() * 1000000.0 / max<long long>(1, totalMicros) << " turns/s" << std::endl;
+  std::cout << "Turn time P50: " << getPercentile(turnMicros, 50) << "us P90: " << getPercentile(turnMicros, 90)
+      << "us P99: " << getPercentile(turnMicros, 99) << "us MaxT: " << turnMicros.back() << "us" << std::endl;
+  vector<Profiler::Entry> sortedScopes;
+  for (auto& scope : scopes)
+    sortedScopes.push_back(scope.second);
+  std::sort(sortedScopes.begin(), sortedScopes.end(),
+      [](const auto& s1, const auto& s2) { return s1.micros > s2.micros; });
+  std::cout << "Most expensive profiled scopes:" << std::endl;
+  for (int i : Range(min(numScopes, sortedScopes.size())))
+    std::cout << "  " << sortedScopes[i].micros / 1000 << "ms " << sortedScopes[i].numCalls << "x "
+        << sortedScopes[i].name << std::endl;
+  if (numDropped > 0)
+    std::cout << numDropped << " timings were dropped from the full profiler buffers" << std::endl;
+  if (maxTurnMillis && getPercentile(turnMicros, 99) > *maxTurnMillis * 1000) {
+    std::cout << "P99 turn time is over the budget of " << *maxTurnMillis << "ms" << std::endl;
+    return false;
+  }
+  return true;
 }
 
 static CreatureList readAlly(ifstream& input) {
@@ -615,8 +975,11 @@ int MainLoop::battleTest(int numTries, const FilePath& levelPath, CreatureList a
   int numAllies = 0;
   int numEnemies = 0;
   int numUnknown = 0;
+  int numTurns = 0;
   auto allyTribe = TribeId::getDarkKeeper();
   std::cout.flush();
+  auto allocations = ObjectPool::getNumAllocations();
+  auto heapAllocations = ObjectPool::getNumHeapAllocations();
   for (int i : Range(numTries)) {
     std::cout << "Creating level" << std::endl;
     auto game = Game::splashScreen(ModelBuilder(&meter, Random, options, sokobanInput, gameConfig,
@@ -624,6 +987,7 @@ int MainLoop::battleTest(int numTries, const FilePath& levelPath, CreatureList a
         .battleModel(levelPath, ally, enemies), CampaignBuilder::getEmptyCampaign());
     std::cout << "Done" << std::endl;
     auto exitCondition = [&](WGame game) -> optional<ExitCondition> {
+      numTurns = game->getGlobalTime().getVisibleInt();
       unordered_set<TribeId, CustomHash<TribeId>> tribes;
       for (auto& m : game->getAllModels())
         for (auto c : m->getAllCreatures())
@@ -666,6 +1030,10 @@ int MainLoop::battleTest(int numTries, const FilePath& levelPath, CreatureList a
   if (numUnknown > 0)
     std::cerr << " (" << numUnknown << ") unknown";
   std::cerr << "\n";
+  if (numTurns > 0)
+    std::cerr << "Objects allocated per turn: " << (ObjectPool::getNumAllocations() - allocations) / numTurns
+        << ", heap allocations per turn: " << (ObjectPool::getNumHeapAllocations() - heapAllocations) / numTurns
+        << (ObjectPool::isEnabled() ? "" : " (object pool disabled)") << "\n";
   return numAllies;
 }
 
@@ -685,8 +1053,53 @@ PModel MainLoop::getBaseModel(ModelBuilder& modelBuilder, CampaignSetup& setup,
   return ret;
 }
 
-Table<PModel> MainLoop::prepareCampaignModels(CampaignSetup& setup, const AvatarInfo& avatarInfo, RandomGen& random) {
+// Every site gets its own generators, names and factories, so the result doesn't depend on
+// the other sites or on the thread that generates it. Sites are generated in parallel at the start of a campaign,
+// and lazy sites on a background thread while the game runs. That is only safe because everything that level
+// generation writes outside of the new model is either per site, like here, or thread-local, like the scratch
+// tables of path finding. New global state reached from level generation has to follow the same rule.
+void MainLoop::withSiteModelBuilder(int seed, function<void(ModelBuilder&)> fun) {
+  RandomGen random(seed);
+  // Creatures and items also draw from the global generator of the current thread
+  RandomGen callerRandom;
+  callerRandom = Random;
+  Random.init(random.get(INT_MAX));
+  OnExit tmp([&] { Random = callerRandom; });
+  auto names = siteNameGenerator->getCopy(random);
+  CreatureFactory siteCreatureFactory(&names);
+  EnemyFactory siteEnemyFactory(random, &names);
+  ModelBuilder modelBuilder(nullptr, random, options, sokobanInput, gameConfig, &siteCreatureFactory,
+      &siteEnemyFactory);
+  fun(modelBuilder);
+}
+
+PModel MainLoop::generateCampaignSite(CampaignSetup& setup, const AvatarInfo& avatarInfo, Vec2 pos, int seed) {
+  PModel ret;
+  withSiteModelBuilder(seed, [&] (ModelBuilder& modelBuilder) {
+    auto& site = setup.campaign.getSites()[pos];
+    if (site.getKeeper())
+      ret = getBaseModel(modelBuilder, setup, avatarInfo);
+    else {
+      auto villain = site.getVillain();
+      CHECK(!!villain);
+      ret = modelBuilder.campaignSiteModel("Campaign enemy site", villain->enemyId, villain->type,
+          avatarInfo.tribeAlignment);
+    }
+  });
+  return ret;
+}
+
+PModel MainLoop::generateVillainSite(EnemyId enemyId, VillainType type, TribeAlignment alignment, int seed) {
+  PModel ret;
+  withSiteModelBuilder(seed, [&] (ModelBuilder& modelBuilder) {
+    ret = modelBuilder.campaignSiteModel("Campaign enemy site", enemyId, type, alignment);
+  });
+  return ret;
+}
+
+CampaignModels MainLoop::prepareCampaignModels(CampaignSetup& setup, const AvatarInfo& avatarInfo, RandomGen& random) {
   Table<PModel> models(setup.campaign.getSites().getBounds());
+  Table<optional<int>> lazySiteSeeds(setup.campaign.getSites().getBounds());
   auto& sites = setup.campaign.getSites();
   for (Vec2 v : sites.getBounds())
     if (auto retired = sites[v].getRetired()) {
@@ -694,19 +1107,32 @@ Table<PModel> MainLoop::prepareCampaignModels(CampaignSetup& setup, const Avatar
         downloadGame(retired->fileInfo.filename);
     }
   optional<string> failedToLoad;
-  int numSites = setup.campaign.getNumNonEmpty();
+  vector<Vec2> generatedSites;
+  Table<int> seeds(sites.getBounds(), 0);
+  for (Vec2 v : sites.getBounds())
+    if (sites[v].getKeeper() || sites[v].getVillain()) {
+      seeds[v] = random.get(INT_MAX);
+      // Sites outside of the influence stay idle, so they're only generated when they come into influence
+      if (sites[v].getVillain() && !setup.campaign.isInInfluence(v) && setup.campaign.getPlayerPos() != v)
+        lazySiteSeeds[v] = seeds[v];
+      else
+        generatedSites.push_back(v);
+    }
+  int numSites = generatedSites.size();
+  for (Vec2 v : sites.getBounds())
+    if (sites[v].getRetired())
+      ++numSites;
   doWithSplash(SplashType::BIG, "Generating map...", numSites,
       [&] (ProgressMeter& meter) {
-        ModelBuilder modelBuilder(nullptr, random, options, sokobanInput, gameConfig, creatureFactory, enemyFactory);
-        for (Vec2 v : sites.getBounds()) {
-          if (!sites[v].isEmpty())
+        ThreadPool threadPool(useSingleThread ? 0 : ThreadPool::getDefaultNumThreads());
+        threadPool.forEach(generatedSites.size(), [&] (int index) {
+          Vec2 v = generatedSites[index];
+          models[v] = generateCampaignSite(setup, avatarInfo, v, seeds[v]);
+          meter.addProgress();
+        });
+        for (Vec2 v : sites.getBounds())
+          if (auto retired = sites[v].getRetired()) {
             meter.addProgress();
-          if (sites[v].getKeeper()) {
-            models[v] = getBaseModel(modelBuilder, setup, avatarInfo);
-          } else if (auto villain = sites[v].getVillain())
-            models[v] = modelBuilder.campaignSiteModel("Campaign enemy site", villain->enemyId, villain->type,
-                avatarInfo.tribeAlignment);
-          else if (auto retired = sites[v].getRetired()) {
             if (PModel m = loadFromFile<PModel>(userPath.file(retired->fileInfo.filename), !useSingleThread))
               models[v] = std::move(m);
             else {
@@ -714,17 +1140,16 @@ Table<PModel> MainLoop::prepareCampaignModels(CampaignSetup& setup, const Avatar
               setup.campaign.clearSite(v);
             }
           }
-        }
       });
   if (failedToLoad)
     view->presentText("Sorry", "Error reading " + *failedToLoad + ". Leaving blank site.");
-  return models;
+  return CampaignModels{std::move(models), std::move(lazySiteSeeds)};
 }
 
 PGame MainLoop::loadGame(const FilePath& file) {
   PGame game;
-  if (auto info = getSavedGameInfo(file))
-    doWithSplash(SplashType::BIG, "Loading "_s + file.getPath() + "...", info->getProgressCount(),
+  if (auto header = getSaveHeader(file))
+    doWithSplash(SplashType::BIG, "Loading "_s + file.getPath() + "...", header->info.getProgressCount(),
         [&] (ProgressMeter& meter) {
           Square::progressMeter = &meter;
           INFO << "Loading from " << file;
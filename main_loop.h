@@ -26,15 +26,32 @@ class GameConfig;
 class AvatarInfo;
 class NameGenerator;
 class EnemyFactory;
+struct CampaignModels;
 
 class MainLoop {
   public:
   MainLoop(View*, Highscores*, FileSharing*, const DirectoryPath& dataFreePath, const DirectoryPath& userPath,
       Options*, Jukebox*, SokobanInput*, GameConfig*, const CreatureFactory*, NameGenerator*, const EnemyFactory*,
       bool useSingleThread, int saveVersion);
+  ~MainLoop();
 
   void start(bool tilesPresent, bool quickGame);
-  void modelGenTest(int numTries, const vector<std::string>& types, RandomGen&, Options*);
+  void modelGenTest(int numTries, const vector<std::string>& types, RandomGen&, Options*,
+      optional<FilePath> jsonPath = none);
+  void largeMapBenchmark(int width, int numPaths, RandomGen&);
+  // Measures saving and loading a saved game in memory, without and with bulk serialization of tables
+  void saveBenchmark(const FilePath&, int numTries);
+  void memoryReport(const FilePath&);
+  // Records the games started from now on to given file, which is overwritten by each new game
+  void setRecording(const FilePath&);
+  // Plays a recorded game in the window, and lets the player continue it when the recording ends
+  void replay(const FilePath&);
+  // Replays a recorded game without a window as fast as possible, and prints the turn times and the most expensive
+  // profiled scopes. Returns false if the 99th percentile of turn times is over the budget.
+  bool replayBenchmark(const FilePath&, optional<double> maxTurnMillis, int numScopes);
+  // Replays a recorded game once through a view that queries the game like the window does, and once through
+  // a DummyView, and returns false if they end differently.
+  bool replayTest(const FilePath&);
   void battleTest(int numTries, const FilePath& levelPath, const FilePath& battleInfoPath, string enemyId, RandomGen&);
   int battleTest(int numTries, const FilePath& levelPath, CreatureList ally, CreatureList enemyId, RandomGen&);
   void endlessTest(int numTries, const FilePath& levelPath, const FilePath& battleInfoPath, RandomGen&, optional<int> numEnemy);
@@ -68,9 +85,12 @@ class MainLoop {
 
   void playMenuMusic();
 
-  Table<PModel> prepareCampaignModels(CampaignSetup& campaign, const AvatarInfo&, RandomGen& random);
+  CampaignModels prepareCampaignModels(CampaignSetup& campaign, const AvatarInfo&, RandomGen& random);
   PGame loadGame(const FilePath&);
   PGame loadPrevious();
+  PGame loadRecording(InputArchive&);
+  // Replays a recorded game until the recording runs out and describes the state that it ended in
+  string replayResult(const FilePath&, View* delegate, bool withMusic);
   FilePath getSavePath(const PGame&, GameSaveType);
   void eraseSaveFile(const PGame&, GameSaveType);
 
@@ -90,6 +110,9 @@ class MainLoop {
   bool useSingleThread;
   SokobanInput* sokobanInput;
   PModel getBaseModel(ModelBuilder&, CampaignSetup&, const AvatarInfo&);
+  PModel generateCampaignSite(CampaignSetup&, const AvatarInfo&, Vec2 site, int seed);
+  PModel generateVillainSite(EnemyId, VillainType, TribeAlignment, int seed);
+  void withSiteModelBuilder(int seed, function<void(ModelBuilder&)>);
   void considerGameEventsPrompt();
   void considerFreeVersionText(bool tilesPresent);
   void eraseAllSavesExcept(const PGame&, optional<GameSaveType>);
@@ -100,8 +123,12 @@ class MainLoop {
   const CreatureFactory* creatureFactory = nullptr;
   NameGenerator* nameGenerator = nullptr;
   const EnemyFactory* enemyFactory = nullptr;
+  // Names for generating sites, kept unchanged and independent of the process's seed, so that a site looks
+  // the same whenever it's generated
+  unique_ptr<NameGenerator> siteNameGenerator;
   void saveGame(PGame&, const FilePath&);
   void saveMainModel(PGame&, const FilePath&);
+  optional<FilePath> recordingPath;
 };
 
 
@@ -53,8 +53,8 @@ MapGui::~MapGui() = default;
 
 static int fireVar = 50;
 
-static Color getFireColor() {
-  return Color(200 + Random.get(-fireVar, fireVar), Random.get(fireVar), Random.get(fireVar), 150);
+static Color getFireColor(RandomGen& random) {
+  return Color(200 + random.get(-fireVar, fireVar), random.get(fireVar), random.get(fireVar), 150);
 }
 
 void MapGui::setButtonViewId(ViewId id) {
@@ -731,10 +731,10 @@ void MapGui::drawObjectAbs(Renderer& renderer, Vec2 pos, const ViewObject& objec
           blendNightColor(Tile::getColor(object), index), tilePos, tile.text, Renderer::HOR);
     if (auto burningVal = object.getAttribute(ViewObject::Attribute::BURNING))
       if (*burningVal > 0) {
-        renderer.drawText(Renderer::SYMBOL_FONT, size.y, getFireColor(),
+        renderer.drawText(Renderer::SYMBOL_FONT, size.y, getFireColor(random),
             pos + Vec2(size.x / 2, -3), u8"ѡ", Renderer::HOR);
         if (*burningVal > 0.5)
-          renderer.drawText(Renderer::SYMBOL_FONT, size.y, getFireColor(),
+          renderer.drawText(Renderer::SYMBOL_FONT, size.y, getFireColor(random),
               pos + Vec2(size.x / 2, -3), u8"Ѡ", Renderer::HOR);
       }
     if (object.hasModifier(ViewObject::Modifier::LOCKED))
@@ -1230,14 +1230,16 @@ void MapGui::render(Renderer& renderer) {
 
 void MapGui::updateObject(Vec2 pos, CreatureView* view, milliseconds currentTime) {
   WLevel level = view->getLevel();
-  objects[pos].emplace();
-  auto& index = *objects[pos];
+  auto& optionalIndex = objects.getWritable(pos);
+  optionalIndex.emplace();
+  auto& index = *optionalIndex;
   view->getViewIndex(pos, index);
   level->setNeedsRenderUpdate(pos, false);
   if (index.hasObject(ViewLayer::FLOOR) || index.hasObject(ViewLayer::FLOOR_BACKGROUND))
     index.setGradient(GradientType::NIGHT, 1.0 - view->getLevel()->getLight(pos));
-  lastSquareUpdate[pos] = currentTime;
-  connectionMap[pos].clear();
+  lastSquareUpdate.getWritable(pos) = currentTime;
+  auto& connections = connectionMap.getWritable(pos);
+  connections.clear();
   shadowed.erase(pos + Vec2(0, 1));
   if (index.hasObject(ViewLayer::FLOOR)) {
     auto& object = index.getObject(ViewLayer::FLOOR);
@@ -1245,14 +1247,14 @@ void MapGui::updateObject(Vec2 pos, CreatureView* view, milliseconds currentTime
     if (tile.wallShadow && !object.hasModifier(ViewObjectModifier::PLANNED)) {
       shadowed.insert(pos + Vec2(0, 1));
     }
-    connectionMap[pos].insert(getConnectionId(object.id()));
+    connections.insert(getConnectionId(object.id()));
   }
   if (index.hasObject(ViewLayer::FLOOR_BACKGROUND)) {
     auto& object = index.getObject(ViewLayer::FLOOR_BACKGROUND);
-    connectionMap[pos].insert(getConnectionId(object.id()));
+    connections.insert(getConnectionId(object.id()));
   }
   if (auto viewId = index.getHiddenId())
-    connectionMap[pos].insert(getConnectionId(*viewId));
+    connections.insert(getConnectionId(*viewId));
 }
 
 double MapGui::getDistanceToEdgeRatio(Vec2 pos) {
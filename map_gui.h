@@ -23,6 +23,7 @@
 #include "entity_map.h"
 #include "view_object.h"
 #include "item_counts.h"
+#include "chunked_table.h"
 
 class MapMemory;
 class MapLayout;
@@ -123,7 +124,8 @@ class MapGui : public GuiElem {
   optional<CreatureInfo> getCreature(Vec2 mousePos);
   void considerContinuousLeftClick(Vec2 mousePos);
   MapLayout* layout;
-  Table<optional<ViewIndex>> objects;
+  // Chunked, so that only the explored parts of large maps take memory
+  ChunkedTable<optional<ViewIndex>> objects;
   bool spriteMode;
   Rectangle levelBounds = Rectangle(1, 1);
   Callbacks callbacks;
@@ -149,7 +151,7 @@ class MapGui : public GuiElem {
   } mouseOffset, center;
   WConstLevel previousLevel = nullptr;
   const CreatureView* previousView = nullptr;
-  Table<optional<milliseconds>> lastSquareUpdate;
+  ChunkedTable<optional<milliseconds>> lastSquareUpdate;
   optional<Coords> softCenter;
   Vec2 lastMousePos;
   optional<Vec2> lastMouseMove;
@@ -161,7 +163,7 @@ class MapGui : public GuiElem {
     int moveCounter;
   };
   optional<ScreenMovement> screenMovement;
-  Table<EnumSet<ViewId>> connectionMap;
+  ChunkedTable<EnumSet<ViewId>> connectionMap;
   bool keyScrolling = false;
   bool mouseUI = false;
   bool lockedView = true;
@@ -203,6 +205,8 @@ class MapGui : public GuiElem {
   //double lastFxTimeReal = -1.0, lastFxTimeTurn = -1.0;
   unique_ptr<fx::FXRenderer> fxRenderer;
   unique_ptr<FXViewManager> fxViewManager;
+  // Rendering doesn't draw from the game's Random, so that a replay doesn't depend on the number of frames
+  RandomGen random;
   void updateFX(milliseconds currentTimeReal);
   void drawFurnitureCracks(Renderer&, Vec2 tilePos, float state, Vec2 pos, Vec2 size);
 };
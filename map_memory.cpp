@@ -19,6 +19,7 @@
 #include "level.h"
 #include "view_object.h"
 #include "view_index.h"
+#include "memory_report.h"
 
 SERIALIZE_DEF(MapMemory, table)
 
@@ -40,6 +41,13 @@ optional<const ViewIndex&> MapMemory::getViewIndex(Position pos) const {
   return table->getReferenceMaybe(pos);
 }
 
+long long MapMemory::getMemoryUsage() const {
+  long long ret = table->getMemoryUsage() + MemoryReport::getSize(updated);
+  for (auto& elem : updated)
+    ret += MemoryReport::getSize(elem.second);
+  return ret;
+}
+
 void MapMemory::update(Position pos, const ViewIndex& index1) {
   auto& index = table->getOrInit(pos);
   index = index1;
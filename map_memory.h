@@ -33,6 +33,7 @@ class MapMemory {
   void clearSquare(Position pos);
   static const MapMemory& empty();
   optional<const ViewIndex&> getViewIndex(Position) const;
+  long long getMemoryUsage() const;
 
   template <class Archive> 
   void serialize(Archive& ar, const unsigned int version);
@@ -0,0 +1,45 @@
+#include "stdafx.h"
+#include "memory_report.h"
+
+MemoryReport::MemoryReport(const string& n) : name(n) {
+}
+
+void MemoryReport::add(const string& name, long long bytes) {
+  addChild(name).bytes += bytes;
+}
+
+MemoryReport& MemoryReport::addChild(const string& name) {
+  children.push_back(unique<MemoryReport>(name));
+  return *children.back();
+}
+
+long long MemoryReport::getTotal() const {
+  long long ret = bytes;
+  for (auto& child : children)
+    ret += child->getTotal();
+  return ret;
+}
+
+static string getSizeString(long long bytes) {
+  if (bytes < 1024 * 1024)
+    return toString(bytes / 1024) + " KB";
+  else
+    return toString(bytes / (1024 * 1024)) + "." + toString(bytes % (1024 * 1024) * 10 / (1024 * 1024)) + " MB";
+}
+
+void MemoryReport::print(ostream& out, int maxDepth) const {
+  print(out, 0, maxDepth);
+}
+
+void MemoryReport::print(ostream& out, int depth, int maxDepth) const {
+  out << string(2 * depth, ' ') << name << ": " << getSizeString(getTotal()) << "\n";
+  if (depth >= maxDepth)
+    return;
+  vector<pair<long long, const MemoryReport*>> sorted;
+  for (auto& child : children)
+    sorted.push_back({child->getTotal(), child.get()});
+  std::stable_sort(sorted.begin(), sorted.end(),
+      [](const auto& c1, const auto& c2) { return c1.first > c2.first; });
+  for (auto& child : sorted)
+    child.second->print(out, depth + 1, maxDepth);
+}
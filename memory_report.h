@@ -0,0 +1,64 @@
+#pragma once
+
+#include "util.h"
+
+// A tree of estimates of the memory used by the parts of a game. The estimates count what objects and
+// containers allocate themselves, using the typical layout of the standard library's nodes, and not what
+// their elements point to, unless the owner adds it.
+class MemoryReport {
+  public:
+  MemoryReport(const string& name);
+
+  void add(const string& name, long long bytes);
+  MemoryReport& addChild(const string& name);
+  long long getTotal() const;
+  void print(ostream&, int maxDepth) const;
+
+  template <typename T>
+  static long long getSize(const vector<T>& v) {
+    return (long long) v.capacity() * sizeof(T);
+  }
+
+  template <typename T>
+  static long long getSize(const Table<T>& table) {
+    return (long long) table.getBounds().area() * sizeof(T);
+  }
+
+  // A node of std::map and std::set holds three pointers and a color next to the value
+  template <typename T>
+  static long long getTreeSize(int numNodes) {
+    return (long long) numNodes * (sizeof(T) + 4 * sizeof(void*));
+  }
+
+  template <typename Key, typename Value, typename Compare>
+  static long long getSize(const std::map<Key, Value, Compare>& m) {
+    return getTreeSize<pair<const Key, Value>>(m.size());
+  }
+
+  template <typename T, typename Compare>
+  static long long getSize(const std::set<T, Compare>& s) {
+    return getTreeSize<T>(s.size());
+  }
+
+  // A hash table node holds the next pointer and the cached hash, and each bucket is one pointer
+  template <typename T>
+  static long long getHashSize(int numNodes, int numBuckets) {
+    return (long long) numNodes * (sizeof(T) + 2 * sizeof(void*)) + (long long) numBuckets * sizeof(void*);
+  }
+
+  template <typename Key, typename Value, typename Hash>
+  static long long getSize(const std::unordered_map<Key, Value, Hash>& m) {
+    return getHashSize<pair<const Key, Value>>(m.size(), m.bucket_count());
+  }
+
+  template <typename T, typename Hash>
+  static long long getSize(const std::unordered_set<T, Hash>& s) {
+    return getHashSize<T>(s.size(), s.bucket_count());
+  }
+
+  private:
+  void print(ostream&, int depth, int maxDepth) const;
+  string name;
+  long long bytes = 0;
+  vector<unique_ptr<MemoryReport>> children;
+};
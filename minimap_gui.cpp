@@ -27,17 +27,28 @@
 void MinimapGui::renderMap(Renderer& renderer, Rectangle target) {
   if (!mapBufferTex)
     mapBufferTex.emplace(mapBuffer);
-  else if (auto error = mapBufferTex->loadFromMaybe(mapBuffer))
-    FATAL << "Failed to render minimap, error: " << toString(*error);
+  else if (dirtyRect)
+    if (auto error = mapBufferTex->loadRegionFromMaybe(mapBuffer, *dirtyRect))
+      FATAL << "Failed to render minimap, error: " << toString(*error);
+  dirtyRect = none;
   renderer.drawImage(target, info.bounds, *mapBufferTex);
   Vec2 topLeft = target.topLeft();
   double scale = min(double(target.width()) / info.bounds.width(),
       double(target.width()) / info.bounds.height());
-  for (Vec2 v : info.roads) {
+  auto roadBounds = info.bounds.intersection(Rectangle(mapBuffer->w, mapBuffer->h));
+  if (roadBounds.area() > 0) {
     Vec2 rrad(1, 1);
-    Vec2 pos = topLeft + (v - info.bounds.topLeft()) * scale;
-    if (pos.inRectangle(target.minusMargin(rrad.x)))
-      renderer.drawFilledRectangle(Rectangle(pos - rrad, pos + rrad), Color::BROWN);
+    auto roadTarget = target.minusMargin(rrad.x);
+    for (int y : roadBounds.getYRange())
+      for (int word = roadBounds.left() / 64; word <= (roadBounds.right() - 1) / 64; ++word)
+        if (auto bits = roads[y * roadRowWords + word])
+          for (int bit = 0; bit < 64; ++bit)
+            if (bits & (uint64_t(1) << bit)) {
+              Vec2 v(word * 64 + bit, y);
+              Vec2 pos = topLeft + (v - info.bounds.topLeft()) * scale;
+              if (v.inRectangle(roadBounds) && pos.inRectangle(roadTarget))
+                renderer.drawFilledRectangle(Rectangle(pos - rrad, pos + rrad), Color::BROWN);
+            }
   }
   Vec2 rad(3, 3);
   Vec2 player = topLeft + (info.player - info.bounds.topLeft()) * scale;
@@ -77,11 +88,18 @@ static Vec2 getMapBufferSize() {
 MinimapGui::MinimapGui(function<void()> f) : clickFun(f) {
   auto size = getMapBufferSize();
   mapBuffer = Texture::createSurface(size.x, size.y);
+  roadRowWords = (size.x + 63) / 64;
+  roads.resize(roadRowWords * size.y, 0);
+}
+
+MinimapGui::~MinimapGui() {
+  SDL::SDL_FreeSurface(mapBuffer);
 }
 
 void MinimapGui::clear() {
   currentLevel = nullptr;
   info = MinimapInfo {};
+  std::fill(roads.begin(), roads.end(), 0);
 }
 
 bool MinimapGui::onLeftClick(Vec2 v) {
@@ -92,7 +110,30 @@ bool MinimapGui::onLeftClick(Vec2 v) {
   return false;
 }
 
-constexpr auto visibleLayers = { ViewLayer::FLOOR_BACKGROUND, ViewLayer::FLOOR };
+constexpr ViewLayer visibleLayers[] = { ViewLayer::FLOOR_BACKGROUND, ViewLayer::FLOOR };
+
+void MinimapGui::setRoad(Vec2 v, bool road) {
+  auto& word = roads[v.y * roadRowWords + v.x / 64];
+  auto bit = uint64_t(1) << (v.x % 64);
+  if (road)
+    word |= bit;
+  else
+    word &= ~bit;
+}
+
+void MinimapGui::markDirty(Rectangle r) {
+  if (!dirtyRect)
+    dirtyRect = r;
+  else
+    dirtyRect = Rectangle(min(dirtyRect->left(), r.left()), min(dirtyRect->top(), r.top()),
+        max(dirtyRect->right(), r.right()), max(dirtyRect->bottom(), r.bottom()));
+}
+
+void MinimapGui::updatePixel(Vec2 pos, Color color, bool road) {
+  Renderer::putPixel(mapBuffer, pos, color);
+  setRoad(pos, road);
+  markDirty(Rectangle(pos, pos + Vec2(1, 1)));
+}
 
 void MinimapGui::update(Rectangle bounds, const CreatureView* creature) {
   auto level = creature->getLevel();
@@ -101,19 +142,24 @@ void MinimapGui::update(Rectangle bounds, const CreatureView* creature) {
   info.locations.clear();
   const MapMemory& memory = creature->getMemory();
   auto updatePos = [&] (Position pos) {
-    if (auto index = memory.getViewIndex(pos))
+    if (auto index = memory.getViewIndex(pos)) {
+      optional<Color> color;
+      bool road = false;
       for (auto layer : visibleLayers)
         if (index->hasObject(layer)) {
           auto& object = index->getObject(layer);
-          Renderer::putPixel(mapBuffer, pos.getCoord(), Tile::getColor(object));
-          if (object.hasModifier(ViewObject::Modifier::ROAD))
-            info.roads.insert(pos.getCoord());
+          color = Tile::getColor(object);
+          road |= object.hasModifier(ViewObject::Modifier::ROAD);
         }
+      if (color)
+        updatePixel(pos.getCoord(), *color, road);
+    }
   };
   if (currentLevel != level) {
     int col = SDL_MapRGBA(mapBuffer->format, 0, 0, 0, 1);
     SDL_FillRect(mapBuffer, nullptr, col);
-    info.roads.clear();
+    std::fill(roads.begin(), roads.end(), 0);
+    markDirty(Rectangle(mapBuffer->w, mapBuffer->h));
     for (Position v : level->getAllPositions())
       updatePos(v);
     currentLevel = level;
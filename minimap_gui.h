@@ -27,6 +27,7 @@ class MinimapGui : public GuiElem {
   public:
 
   MinimapGui(function<void()> clickFun);
+  ~MinimapGui();
 
   void update(Rectangle bounds, const CreatureView*);
   void clear();
@@ -37,11 +38,12 @@ class MinimapGui : public GuiElem {
 
   private:
 
-  void putMapPixel(Vec2 pos, Color col);
+  void updatePixel(Vec2 pos, Color col, bool road);
+  void markDirty(Rectangle);
+  void setRoad(Vec2, bool);
 
   struct MinimapInfo {
     Rectangle bounds;
-    unordered_set<Vec2, CustomHash<Vec2>> roads;
     vector<Vec2> enemies;
     Vec2 player;
     vector<Vec2> locations;
@@ -51,6 +53,11 @@ class MinimapGui : public GuiElem {
 
   SDL::SDL_Surface* mapBuffer;
   optional<Texture> mapBufferTex;
+  // Part of mapBuffer that was modified since the last upload to mapBufferTex.
+  optional<Rectangle> dirtyRect;
+  // One bit per map position, each row padded to whole words.
+  vector<uint64_t> roads;
+  int roadRowWords;
   WConstLevel currentLevel = nullptr;
 };
 
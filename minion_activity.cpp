@@ -62,41 +62,38 @@ static WCreature getCopulationTarget(WConstCollective collective, WConstCreature
 }
 
 const vector<FurnitureType>& MinionActivities::getAllFurniture(MinionActivity task) {
-  static EnumMap<MinionActivity, vector<FurnitureType>> cache;
-  static bool initialized = false;
-  if (!initialized) {
-    for (auto minionTask : ENUM_ALL(MinionActivity)) {
-      auto& taskInfo = CollectiveConfig::getActivityInfo(minionTask);
-      switch (taskInfo.type) {
-        case MinionActivityInfo::ARCHERY:
-          cache[minionTask].push_back(FurnitureType::ARCHERY_RANGE);
-          break;
-        case MinionActivityInfo::FURNITURE:
-          for (auto furnitureType : ENUM_ALL(FurnitureType))
-            if (taskInfo.furniturePredicate(nullptr, nullptr, furnitureType))
-              cache[minionTask].push_back(furnitureType);
-          break;
-        default: break;
-      }
+  // Initialized statically, because it may be called by several threads generating campaign sites
+  static EnumMap<MinionActivity, vector<FurnitureType>> cache([](MinionActivity minionTask) {
+    vector<FurnitureType> ret;
+    auto& taskInfo = CollectiveConfig::getActivityInfo(minionTask);
+    switch (taskInfo.type) {
+      case MinionActivityInfo::ARCHERY:
+        ret.push_back(FurnitureType::ARCHERY_RANGE);
+        break;
+      case MinionActivityInfo::FURNITURE:
+        for (auto furnitureType : ENUM_ALL(FurnitureType))
+          if (taskInfo.furniturePredicate(nullptr, nullptr, furnitureType))
+            ret.push_back(furnitureType);
+        break;
+      default: break;
     }
-    initialized = true;
-  }
+    return ret;
+  });
   return cache[task];
 }
 
 optional<MinionActivity> MinionActivities::getActivityFor(WConstCollective col, WConstCreature c, FurnitureType type) {
-  static EnumMap<FurnitureType, optional<MinionActivity>> cache;
-  static bool initialized = false;
-  if (!initialized) {
+  static const EnumMap<FurnitureType, optional<MinionActivity>> cache = [] {
+    EnumMap<FurnitureType, optional<MinionActivity>> ret;
     for (auto task : ENUM_ALL(MinionActivity))
       for (auto furnitureType : getAllFurniture(task)) {
-        CHECK(!cache[furnitureType]) << "Minion tasks " << EnumInfo<MinionActivity>::getString(task) << " and "
-            << EnumInfo<MinionActivity>::getString(*cache[furnitureType]) << " both assigned to "
+        CHECK(!ret[furnitureType]) << "Minion tasks " << EnumInfo<MinionActivity>::getString(task) << " and "
+            << EnumInfo<MinionActivity>::getString(*ret[furnitureType]) << " both assigned to "
             << EnumInfo<FurnitureType>::getString(furnitureType);
-        cache[furnitureType] = task;
+        ret[furnitureType] = task;
       }
-    initialized = true;
-  }
+    return ret;
+  }();
   if (auto task = cache[type]) {
     auto& info = CollectiveConfig::getActivityInfo(*task);
     if (info.furniturePredicate(col, c, type))
@@ -28,6 +28,7 @@
 #include "square.h"
 #include "view_id.h"
 #include "collective.h"
+#include "game_event.h"
 #include "music.h"
 #include "level_maker.h"
 #include "map_memory.h"
@@ -55,13 +56,18 @@
 #include "unknown_locations.h"
 #include "avatar_info.h"
 #include "collective_config.h"
+#include "thread_pool.h"
+#include "stair_navigation.h"
+#include "memory_report.h"
 
 template <class Archive> 
 void Model::serialize(Archive& ar, const unsigned int version) {
   CHECK(!serializationLocked);
   ar & SUBCLASS(OwnedObject<Model>);
   ar(levels, collectives, timeQueue, deadCreatures, currentTime, woodCount, game, lastTick);
-  ar(stairNavigation, cemetery, mainLevels, eventGenerator, externalEnemies);
+  ar(cemetery, mainLevels, eventGenerator, externalEnemies);
+  if (Archive::is_loading::value)
+    calculateStairNavigation();
 }
 
 SERIALIZATION_CONSTRUCTOR_IMPL(Model)
@@ -69,6 +75,7 @@ SERIALIZATION_CONSTRUCTOR_IMPL(Model)
 SERIALIZABLE(Model)
 
 void Model::discardForRetirement() {
+  ++changeCount;
   serializationLocked = true;
   deadCreatures.clear();
 }
@@ -88,11 +95,26 @@ int Model::getSaveProgressCount() const {
   return ret;
 }
 
+int Model::getChangeCount() const {
+  return changeCount;
+}
+
+void Model::addMemoryUsage(MemoryReport& report) const {
+  for (auto& level : levels)
+    level->addMemoryUsage(report);
+  if (cemetery)
+    cemetery->addMemoryUsage(report);
+  for (auto& collective : collectives)
+    collective->addMemoryUsage(report);
+  report.add("dead creatures", MemoryReport::getSize(deadCreatures) + deadCreatures.size() * sizeof(Creature));
+}
+
 vector<WCollective> Model::getCollectives() const {
   return getWeakPointers(collectives);
 }
 
 void Model::updateSunlightMovement() {
+  ++changeCount;
   for (PLevel& l : levels)
     l->updateSunlightMovement();
 }
@@ -110,6 +132,7 @@ void Model::checkCreatureConsistency() {
 }
 
 bool Model::update(double totalTime) {
+  ++changeCount;
   currentTime = totalTime;
   if (WCreature creature = timeQueue->getNextCreature(totalTime)) {
     CHECK(creature->getLevel() != nullptr) << "Creature misplaced before processing: " << creature->getName().bare() <<
@@ -118,10 +141,14 @@ bool Model::update(double totalTime) {
       checkCreatureConsistency();
       FATAL << "Dead: " << creature->getName().bare();
     }
+    bool newTurn = false;
     while (totalTime > lastTick.getDouble()) {
       lastTick += 1_visible;
       tick(lastTick);
+      newTurn = true;
     }
+    if (newTurn)
+      precomputePaths();
     CHECK(creature->getLevel() != nullptr) << "Creature misplaced before moving: " << creature->getName().bare() <<
         ". Any idea why this happened?";
     if (!creature->isDead()) {
@@ -137,6 +164,29 @@ bool Model::update(double totalTime) {
   return false;
 }
 
+static unique_ptr<ThreadPool> pathThreadPool;
+
+void Model::setNumPathThreads(int num) {
+  pathThreadPool = unique<ThreadPool>(num);
+}
+
+void Model::precomputePaths() {
+  PROFILE;
+  vector<WCreature> creatures;
+  for (WCreature c : timeQueue->getAllCreatures()) {
+    c->discardPrecomputedPath();
+    if (timeQueue->willMoveThisTurn(c) && c->shouldPrecomputePath())
+      creatures.push_back(c);
+  }
+  // Path finding only reads the level, and every creature only writes its own path
+  auto compute = [&] (int index) { creatures[index]->precomputePath(); };
+  if (pathThreadPool)
+    pathThreadPool->forEach(creatures.size(), compute);
+  else
+    for (int i : All(creatures))
+      compute(i);
+}
+
 void Model::tick(LocalTime time) { PROFILE
   for (WCreature c : timeQueue->getAllCreatures()) {
     c->tick();
@@ -154,6 +204,7 @@ void Model::addCreature(PCreature c) {
 }
 
 void Model::addCreature(PCreature c, TimeInterval delay) {
+  ++changeCount;
   if (auto game = getGame())
     c->setGlobalTime(getGame()->getGlobalTime());
   timeQueue->addCreature(std::move(c), getLocalTime() + delay);
@@ -221,44 +272,37 @@ WLevel Model::getLinkedLevel(WLevel from, StairKey key) const {
   return nullptr;
 }
 
-static pair<LevelId, LevelId> getIds(WConstLevel l1, WConstLevel l2) {
-  return {l1->getUniqueId(), l2->getUniqueId()};
-}
-
 void Model::calculateStairNavigation() {
-  stairNavigation.clear();
-  // Floyd-Warshall algorithm
-  for (auto l1 : getLevels())
-    for (auto l2 : getLevels())
-      if (l1 != l2)
-        if (auto stairKey = getStairsBetween(l1, l2))
-          stairNavigation[getIds(l1, l2)] = *stairKey;
-  for (auto li : getLevels())
-    for (auto l1 : getLevels())
-      if (li != l1)
-        for (auto l2 : getLevels())
-          if (l2 != l1 && l2 != li && !stairNavigation.count(getIds(l1, l2)) &&
-              stairNavigation.count(getIds(li, l2)) && stairNavigation.count(getIds(l1, li)))
-            stairNavigation[getIds(l1, l2)] = stairNavigation.at(getIds(l1, li));
-  for (auto l1 : getLevels())
-    for (auto l2 : getLevels())
-      if (l1 != l2)
-        CHECK(stairNavigation.count(getIds(l1, l2))) <<
-            "No stair path between levels " << l1->getName() << " " << l2->getName();
-}
-
-optional<StairKey> Model::getStairsBetween(WConstLevel from, WConstLevel to) {
-  for (StairKey key : from->getAllStairKeys())
-    if (to->hasStairKey(key))
-      return key;
+  levelIndex.clear();
+  vector<vector<StairKey>> levelStairs;
+  for (int i : All(levels)) {
+    levelIndex[levels[i]->getUniqueId()] = i;
+    levelStairs.push_back(levels[i]->getAllStairKeys());
+  }
+  // Stairs are added one at a time while the model is built, so most updates don't change the graph
+  if (!stairNavigation->update(levelStairs))
+    return;
+  if (auto disconnected = stairNavigation->getDisconnected())
+    FATAL << "No stair path between levels " << levels[disconnected->first]->getName() << " "
+        << levels[disconnected->second]->getName();
+}
+
+optional<int> Model::getLevelIndex(WConstLevel level) const {
+  if (auto index = getValueMaybe(levelIndex, level->getUniqueId()))
+    if (*index < levels.size() && levels[*index].get() == level)
+      return index;
   return none;
 }
 
 optional<Position> Model::getStairs(WConstLevel from, WConstLevel to) {
   CHECK(from != to);
-  if (!getLevels().contains(from) || !getLevels().contains(to) || !stairNavigation.count(getIds(from, to)))
+  auto fromIndex = getLevelIndex(from);
+  auto toIndex = getLevelIndex(to);
+  if (!fromIndex || !toIndex)
     return none;
-  return Random.choose(from->getLandingSquares(stairNavigation.at(getIds(from, to))));
+  if (auto key = stairNavigation->getNextStairs(*fromIndex, *toIndex))
+    return Random.choose(from->getLandingSquares(*key));
+  return none;
 }
 
 vector<WLevel> Model::getLevels() const {
@@ -278,11 +322,13 @@ WLevel Model::getTopLevel() const {
 }
 
 void Model::killCreature(WCreature c) {
+  ++changeCount;
   deadCreatures.push_back(timeQueue->removeCreature(c));
   cemetery->landCreature(cemetery->getAllPositions(), c);
 }
 
 PCreature Model::extractCreature(WCreature c) {
+  ++changeCount;
   PCreature ret = timeQueue->removeCreature(c);
   c->getLevel()->removeCreature(c);
   return ret;
@@ -329,6 +375,44 @@ void Model::clearExternalEnemies() {
   externalEnemies = none;
 }
 
+// The model where the event happened, or null if it concerns the whole game or the place isn't known
+static WModel getEventModel(const GameEvent& event) {
+  using namespace EventInfo;
+  WModel ret = nullptr;
+  auto creatureModel = [&](WCreature c) {
+    if (c)
+      ret = c->getPosition().getModel();
+  };
+  event.visit(
+      [&](const CreatureMoved& info) { creatureModel(info.creature); },
+      [&](const CreatureKilled& info) { creatureModel(info.victim); },
+      [&](const ItemsPickedUp& info) { creatureModel(info.creature); },
+      [&](const ItemsDropped& info) { creatureModel(info.creature); },
+      [&](const ItemsAppeared& info) { ret = info.position.getModel(); },
+      [&](const Projectile& info) { ret = info.begin.getModel(); },
+      [&](const ConqueredEnemy& info) { ret = info.collective->getModel(); },
+      [&](const Alarm& info) { ret = info.pos.getModel(); },
+      [&](const CreatureTortured& info) { creatureModel(info.victim); },
+      [&](const CreatureStunned& info) { creatureModel(info.victim); },
+      [&](const CreatureAttacked& info) { creatureModel(info.victim); },
+      [&](const MovementChanged& info) { ret = info.pos.getModel(); },
+      [&](const TrapTriggered& info) { ret = info.pos.getModel(); },
+      [&](const TrapDisarmed& info) { ret = info.pos.getModel(); },
+      [&](const FurnitureDestroyed& info) { ret = info.position.getModel(); },
+      [&](const ItemsEquipped& info) { creatureModel(info.creature); },
+      [&](const CreatureEvent& info) { creatureModel(info.creature); },
+      [&](const VisibilityChanged& info) { ret = info.pos.getModel(); },
+      [&](const FX& info) { ret = info.position.getModel(); },
+      [&](const auto&) {}
+  );
+  return ret;
+}
+
 void Model::addEvent(const GameEvent& e) {
+  // Every model gets every event, but only the ones from this model can change it. This keeps the saved
+  // copies of frozen sites in use between saves.
+  auto model = getEventModel(e);
+  if (!model || model == this)
+    ++changeCount;
   eventGenerator->addEvent(e);
 }
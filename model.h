@@ -35,6 +35,8 @@ class ExternalEnemies;
 class Options;
 class AvatarInfo;
 class GameConfig;
+class StairNavigation;
+class MemoryReport;
 
 /**
   * Main class that holds all game logic.
@@ -71,6 +73,10 @@ class Model : public OwnedObject<Model> {
   void setGame(WGame);
   WGame getGame() const;
   void tick(LocalTime);
+
+  /** Sets the number of threads used to compute paths of creatures that move in the next turn.
+      The results don't depend on the number of threads.*/
+  static void setNumPathThreads(int);
   vector<WCollective> getCollectives() const;
   vector<WCreature> getAllCreatures() const;
   vector<WLevel> getLevels() const;
@@ -83,6 +89,10 @@ class Model : public OwnedObject<Model> {
   int getWoodCount() const;
 
   int getSaveProgressCount() const;
+  // Increased by everything that can change a model that isn't simulated, so a site that didn't change
+  // since the last save can reuse its saved copy
+  int getChangeCount() const;
+  void addMemoryUsage(MemoryReport&) const;
 
   void killCreature(WCreature victim);
   void updateSunlightMovement();
@@ -124,13 +134,17 @@ class Model : public OwnedObject<Model> {
   vector<PCreature> SERIAL(deadCreatures);
   double SERIAL(currentTime) = 0;
   int SERIAL(woodCount) = 0;
-  optional<StairKey> getStairsBetween(WConstLevel from, WConstLevel to);
-  map<pair<LevelId, LevelId>, StairKey> SERIAL(stairNavigation);
+  optional<int> getLevelIndex(WConstLevel) const;
+  // Not serialized, recalculated after loading
+  HeapAllocated<StairNavigation> stairNavigation;
+  unordered_map<LevelId, int> levelIndex;
   bool serializationLocked = false;
+  int changeCount = 0;
   template <typename>
   friend class EventListener;
   OwnerPointer<EventGenerator> SERIAL(eventGenerator);
   void checkCreatureConsistency();
+  void precomputePaths();
   heap_optional<ExternalEnemies> SERIAL(externalEnemies);
   int moveCounter = 0;
 };
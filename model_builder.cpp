@@ -142,6 +142,14 @@ PModel ModelBuilder::singleMapModel(const string& worldName, TribeId keeperTribe
   return tryBuilding(10, [&] { return trySingleMapModel(worldName, keeperTribe, alignment);}, "single map");
 }
 
+PModel ModelBuilder::largeMapModel(int width) {
+  auto keeperTribe = TribeId::getDarkKeeper();
+  return tryBuilding(10, [&] {
+    return tryModel(width, "large map", getSingleMapEnemiesForEvilKeeper(keeperTribe), keeperTribe, BiomeId::GRASSLAND,
+        {}, true);
+  }, "large map");
+}
+
 vector<EnemyInfo> ModelBuilder::getSingleMapEnemiesForEvilKeeper(TribeId keeperTribe) {
   vector<EnemyInfo> enemies;
   for (int i : Range(random.get(3, 6)))
@@ -379,7 +387,7 @@ PModel ModelBuilder::campaignSiteModel(const string& siteName, EnemyId enemyId,
       EnumInfo<EnemyId>::getString(enemyId));
 }
 
-void ModelBuilder::measureSiteGen(int numTries, vector<string> types) {
+optional<vector<ModelBuilder::SiteGenCase>> ModelBuilder::getSiteGenCases(vector<string> types) {
   if (types.empty()) {
     types = {"single_map", "campaign_base", "tutorial"};
     for (auto id : ENUM_ALL(EnemyId)) {
@@ -388,59 +396,37 @@ void ModelBuilder::measureSiteGen(int numTries, vector<string> types) {
         types.push_back(EnumInfo<EnemyId>::getString(id));
     }
   }
-  vector<function<void()>> tasks;
-  auto tribe = TribeId::getDarkKeeper();
+  vector<SiteGenCase> ret;
   for (auto& type : types) {
-    if (type == "single_map")
-      for (auto alignment : ENUM_ALL(TribeAlignment))
-        tasks.push_back([=] { measureModelGen(type, numTries, [&] { trySingleMapModel("pok", tribe, alignment); }); });
-    else if (type == "campaign_base")
-      for (auto alignment : ENUM_ALL(TribeAlignment))
-        tasks.push_back([=] { measureModelGen(type, numTries,
-            [&] { tryCampaignBaseModel("pok", tribe, alignment, false); }); });
-    else if (type == "tutorial")
-      tasks.push_back([=] { measureModelGen(type, numTries, [&] { tryTutorialModel("pok"); }); });
-    else if (auto id = EnumInfo<EnemyId>::fromStringSafe(type)) {
+    if (type == "tutorial")
+      ret.push_back(SiteGenCase{type, none});
+    else if (type == "single_map" || type == "campaign_base" || EnumInfo<EnemyId>::fromStringSafe(type)) {
       for (auto alignment : ENUM_ALL(TribeAlignment))
-        tasks.push_back([=] { measureModelGen(type, numTries, [&] {
-            tryCampaignSiteModel("", *id, VillainType::LESSER, alignment); }); });
+        ret.push_back(SiteGenCase{type, alignment});
     } else {
       std::cout << "Bad map type: " << type << std::endl;
-      return;
+      return none;
     }
   }
-  for (auto& t : tasks)
-    t();
+  return ret;
 }
 
-void ModelBuilder::measureModelGen(const string& name, int numTries, function<void()> genFun) {
-  int numSuccess = 0;
-  int maxT = 0;
-  int minT = 1000000;
-  double sumT = 0;
-  std::cout << name;
-  for (int i : Range(numTries)) {
-#ifndef OSX // this triggers some compiler errors OSX, I don't need it there anyway.
-    auto time = steady_clock::now();
-#endif
-    try {
-      genFun();
-      ++numSuccess;
-      std::cout << ".";
-      std::cout.flush();
-    } catch (LevelGenException) {
-      std::cout << "x";
-      std::cout.flush();
-    }
-#ifndef OSX
-    int millis = duration_cast<milliseconds>(steady_clock::now() - time).count();
-    sumT += millis;
-    maxT = max(maxT, millis);
-    minT = min(minT, millis);
-#endif
+bool ModelBuilder::trySiteGen(const SiteGenCase& genCase) {
+  auto tribe = TribeId::getDarkKeeper();
+  try {
+    if (genCase.type == "single_map")
+      trySingleMapModel("pok", tribe, *genCase.alignment);
+    else if (genCase.type == "campaign_base")
+      tryCampaignBaseModel("pok", tribe, *genCase.alignment, false);
+    else if (genCase.type == "tutorial")
+      tryTutorialModel("pok");
+    else
+      tryCampaignSiteModel("", *EnumInfo<EnemyId>::fromStringSafe(genCase.type), VillainType::LESSER,
+          *genCase.alignment);
+    return true;
+  } catch (LevelGenException) {
+    return false;
   }
-  std::cout << std::endl << numSuccess << " / " << numTries << ". MinT: " <<
-    minT << ". MaxT: " << maxT << ". AvgT: " << sumT / numTries << std::endl;
 }
 
 PModel ModelBuilder::tryModel(int width, const string& levelName, vector<EnemyInfo> enemyInfo,
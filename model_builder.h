@@ -26,8 +26,18 @@ class ModelBuilder {
   PModel campaignBaseModel(const string& siteName, TribeId keeperTribe, TribeAlignment, bool externalEnemies);
   PModel campaignSiteModel(const string& siteName, EnemyId, VillainType, TribeAlignment);
   PModel tutorialModel(const string& siteName);
+  // A single map keeper site of given width, used to benchmark large maps
+  PModel largeMapModel(int width);
 
-  void measureSiteGen(int numTries, vector<string> types);
+  // Used by the world generation test. Every case is a site type and the keeper's alignment, if it matters.
+  struct SiteGenCase {
+    string type;
+    optional<TribeAlignment> alignment;
+  };
+  // Returns all cases of given site types or enemy ids (all types if empty), or none if a type is unknown.
+  optional<vector<SiteGenCase>> getSiteGenCases(vector<string> types);
+  // Makes a single attempt to generate the site and returns false if it failed
+  bool trySiteGen(const SiteGenCase&);
 
   PModel splashModel(const FilePath& splashPath);
   PModel battleModel(const FilePath& levelPath, CreatureList allies, CreatureList enemies);
@@ -37,7 +47,6 @@ class ModelBuilder {
   ~ModelBuilder();
 
   private:
-  void measureModelGen(const std::string& name, int numTries, function<void()> genFun);
   PModel trySingleMapModel(const string& worldName, TribeId keeperTribe, TribeAlignment);
   PModel tryCampaignBaseModel(const string& siteName, TribeId keeperTribe, TribeAlignment, bool externalEnemies);
   PModel tryTutorialModel(const string& siteName);
@@ -38,7 +38,7 @@ void Jukebox::toggle(bool state) {
     return;
   on = state;
   if (on) {
-    current = Random.choose(byType[getCurrentType()]);
+    current = random.choose(byType[getCurrentType()]);
     currentPlaying = current;
     play(current);
   } else
@@ -53,7 +53,7 @@ void Jukebox::setCurrentVolume(int v) {
 }
 
 void Jukebox::setCurrent(MusicType c) {
-  current = Random.choose(byType[c]);
+  current = random.choose(byType[c]);
 }
 
 void Jukebox::continueCurrent() {
@@ -81,7 +81,7 @@ void Jukebox::setType(MusicType c, bool now) {
     if (byType[c].empty())
       return;
     if (getCurrentType() != c)
-      current = Random.choose(byType[c]);
+      current = random.choose(byType[c]);
   }
 }
 
@@ -55,4 +55,6 @@ class Jukebox {
   optional<MusicType> nextType;
   optional<AsyncLoop> refreshLoop;
   AudioDevice& audioDevice;
+  // Not the game's Random, so that a replay doesn't depend on whether music is on
+  RandomGen random;
 };
@@ -38,6 +38,10 @@ class vector {
     return (int) impl.size();
   }
 
+  int capacity() const {
+    return (int) impl.capacity();
+  }
+
   bool empty() const {
     return impl.empty();
   }
@@ -19,23 +19,23 @@
 #include "util.h"
 #include "file_path.h"
 
-string getSyllable() {
+string getSyllable(RandomGen& random) {
   string vowels = "aeyuio";
   string consonants = "qwrtplkjhgfdszxcvbnm";
   string ret;
-  if (Random.roll(3))
-    ret += consonants[Random.get(consonants.size())];
-  ret += vowels[Random.get(vowels.size())];
-  if (Random.roll(3))
-    ret += consonants[Random.get(consonants.size())];
+  if (random.roll(3))
+    ret += consonants[random.get(consonants.size())];
+  ret += vowels[random.get(vowels.size())];
+  if (random.roll(3))
+    ret += consonants[random.get(consonants.size())];
   return ret;
 }
 
-string getWord() {
-  int syllables = Random.choose({1, 2, 3, 4}, {1, 4, 3, 1});
+string getWord(RandomGen& random) {
+  int syllables = random.choose({1, 2, 3, 4}, {1, 4, 3, 1});
   string ret;
   for (int i : Range(syllables))
-    ret += getSyllable();
+    ret += getSyllable(random);
   return ret;
 }
 
@@ -49,18 +49,18 @@ vector<string> readLines(const FilePath& path) {
   return input;
 }
 
-NameGenerator::NameGenerator(const DirectoryPath& namesPath) {
+NameGenerator::NameGenerator(const DirectoryPath& namesPath, RandomGen& random) {
   vector<string> input;
   for (int i : Range(1000)) {
     string ret;
-    int parts = Random.choose({1, 2}, {3, 1});
+    int parts = random.choose({1, 2}, {3, 1});
     for (int k : Range(parts))
-      ret += getWord() + " ";
+      ret += getWord(random) + " ";
     trim(ret);
     input.push_back(ret);
   }
   auto set = [&] (NameGeneratorId id, vector<string> input) {
-    for (string name : Random.permutation(input))
+    for (string name : random.permutation(input))
       names[id].push(name);
   };
   set(NameGeneratorId::SCROLL, input);
@@ -89,3 +89,15 @@ string NameGenerator::getNext(NameGeneratorId id) {
   names[id].push(ret);
   return ret;
 }
+
+NameGenerator NameGenerator::getCopy(RandomGen& random) const {
+  NameGenerator ret(*this);
+  for (auto id : ENUM_ALL(NameGeneratorId)) {
+    auto& list = ret.names[id];
+    for (int i : Range(list.empty() ? 0 : random.get(list.size()))) {
+      list.push(list.front());
+      list.pop();
+    }
+  }
+  return ret;
+}
@@ -40,9 +40,13 @@ class DirectoryPath;
 
 class NameGenerator {
   public:
-  NameGenerator(const DirectoryPath&);
+  NameGenerator(const DirectoryPath&, RandomGen&);
   string getNext(NameGeneratorId);
 
+  // Returns a copy with every list starting at a random position. Lets independent generators
+  // draw names without sharing state.
+  NameGenerator getCopy(RandomGen&) const;
+
   private:
   EnumMap<NameGeneratorId, queue<string>> names;
 };
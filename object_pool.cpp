@@ -0,0 +1,110 @@
+#include "stdafx.h"
+#include "object_pool.h"
+#include "debug.h"
+
+static constexpr size_t granularity = 16;
+static constexpr size_t maxPooledSize = 4096;
+static constexpr int numSizeClasses = maxPooledSize / granularity;
+static constexpr size_t chunkSize = 64 * 1024;
+
+namespace {
+struct FreeBlock {
+  FreeBlock* next;
+};
+}
+
+static atomic<bool> enabled(true);
+static atomic<long long> numAllocations(0);
+static atomic<long long> numHeapAllocations(0);
+
+// Free lists left behind by threads that have finished
+static std::mutex orphanMutex;
+static FreeBlock* orphans[numSizeClasses];
+
+// Plain array, so it stays usable while other thread locals are being destroyed
+static thread_local FreeBlock* freeLists[numSizeClasses];
+
+namespace {
+struct OrphanFreeLists {
+  bool initialized = false;
+  ~OrphanFreeLists() {
+    std::lock_guard<std::mutex> lock(orphanMutex);
+    for (int i = 0; i < numSizeClasses; ++i)
+      while (FreeBlock* block = freeLists[i]) {
+        freeLists[i] = block->next;
+        block->next = orphans[i];
+        orphans[i] = block;
+      }
+  }
+};
+}
+
+static thread_local OrphanFreeLists orphanOnExit;
+
+static int getSizeClass(size_t size) {
+  return int((max<size_t>(size, 1) + granularity - 1) / granularity) - 1;
+}
+
+static void refill(int sizeClass) {
+  orphanOnExit.initialized = true;
+  {
+    std::lock_guard<std::mutex> lock(orphanMutex);
+    if (orphans[sizeClass]) {
+      freeLists[sizeClass] = orphans[sizeClass];
+      orphans[sizeClass] = nullptr;
+      return;
+    }
+  }
+  size_t blockSize = (sizeClass + 1) * granularity;
+  char* chunk = static_cast<char*>(::operator new(chunkSize));
+  numHeapAllocations.fetch_add(1, std::memory_order_relaxed);
+  for (size_t offset = 0; offset + blockSize <= chunkSize; offset += blockSize) {
+    auto block = reinterpret_cast<FreeBlock*>(chunk + offset);
+    block->next = freeLists[sizeClass];
+    freeLists[sizeClass] = block;
+  }
+}
+
+void* ObjectPool::allocate(size_t size) {
+  numAllocations.fetch_add(1, std::memory_order_relaxed);
+  if (!enabled || size > maxPooledSize) {
+    numHeapAllocations.fetch_add(1, std::memory_order_relaxed);
+    return ::operator new(size);
+  }
+  int sizeClass = getSizeClass(size);
+  if (!freeLists[sizeClass])
+    refill(sizeClass);
+  FreeBlock* block = freeLists[sizeClass];
+  freeLists[sizeClass] = block->next;
+  return block;
+}
+
+void ObjectPool::deallocate(void* p, size_t size) {
+  if (!p)
+    return;
+  if (!enabled || size > maxPooledSize) {
+    ::operator delete(p);
+    return;
+  }
+  int sizeClass = getSizeClass(size);
+  auto block = static_cast<FreeBlock*>(p);
+  block->next = freeLists[sizeClass];
+  freeLists[sizeClass] = block;
+}
+
+void ObjectPool::setEnabled(bool state) {
+  CHECK(numAllocations == 0) << "Object pool can't be switched after objects were allocated";
+  enabled = state;
+}
+
+bool ObjectPool::isEnabled() {
+  return enabled;
+}
+
+long long ObjectPool::getNumAllocations() {
+  return numAllocations;
+}
+
+long long ObjectPool::getNumHeapAllocations() {
+  return numHeapAllocations;
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+
+// Allocates memory for game objects from free lists of fixed size blocks. Every thread keeps its own free
+// lists, so neither allocation nor freeing takes a lock, and blocks freed by a thread that exits are handed
+// over to the other threads. Memory is never given back to the system.
+class ObjectPool {
+  public:
+  static void* allocate(std::size_t size);
+  static void deallocate(void*, std::size_t size);
+
+  // Must be called before any object is allocated
+  static void setEnabled(bool);
+  static bool isEnabled();
+
+  // Number of objects allocated through the pool and number of calls to the system allocator it made
+  static long long getNumAllocations();
+  static long long getNumHeapAllocations();
+};
+
+// Objects of classes that derive from this are allocated from the ObjectPool, both by makeOwner and when
+// they are created while loading a game.
+class PoolAllocated {
+  public:
+  static void* operator new(std::size_t size) {
+    return ObjectPool::allocate(size);
+  }
+
+  static void operator delete(void* p, std::size_t size) {
+    ObjectPool::deallocate(p, size);
+  }
+};
+
+// Allocator for std::allocate_shared, so the object and its control block share one pooled block
+template <typename T>
+class PoolAllocator {
+  public:
+  using value_type = T;
+
+  PoolAllocator() {}
+
+  template <typename U>
+  PoolAllocator(const PoolAllocator<U>&) {}
+
+  T* allocate(std::size_t n) {
+    return static_cast<T*>(ObjectPool::allocate(n * sizeof(T)));
+  }
+
+  void deallocate(T* p, std::size_t n) {
+    ObjectPool::deallocate(p, n * sizeof(T));
+  }
+
+  template <typename U>
+  bool operator == (const PoolAllocator<U>&) const {
+    return true;
+  }
+
+  template <typename U>
+  bool operator != (const PoolAllocator<U>&) const {
+    return false;
+  }
+};
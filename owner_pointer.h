@@ -4,6 +4,7 @@
 #include "serialization.h"
 #include "debug.h"
 #include "my_containers.h"
+#include "object_pool.h"
 
 template <typename T>
 class WeakPointer;
@@ -84,11 +85,11 @@ class WeakPointer {
   public:
 
   template <typename U>
-  WeakPointer(const WeakPointer<U>& o) : elem(o.elem) {
+  WeakPointer(const WeakPointer<U>& o) : elem(o.elem), ptr(o.ptr) {
   }
 
   template <typename U>
-  WeakPointer(WeakPointer<U>&& o) : elem(std::move(o.elem)) {
+  WeakPointer(WeakPointer<U>&& o) : elem(std::move(o.elem)), ptr(o.ptr) {
   }
 
   WeakPointer(T* t) : WeakPointer(t->getThis().template dynamicCast<T>()) {}
@@ -99,17 +100,19 @@ class WeakPointer {
   template <typename U>
   WeakPointer<T>& operator = (WeakPointer<U>&& o) {
     elem = std::move(o.elem);
+    ptr = o.ptr;
     return *this;
   }
 
   template <typename U>
   WeakPointer<T>& operator = (const WeakPointer<U>& o) {
     elem = o.elem;
+    ptr = o.ptr;
     return *this;
   }
 
   WeakPointer<T>& operator = (std::nullptr_t) {
-    elem.reset();
+    clear();
     return *this;
   }
 
@@ -126,22 +129,23 @@ class WeakPointer {
 
   void clear() {
     elem.reset();
+    ptr = nullptr;
   }
 
   T* operator -> () const {
-    return elem.lock().get();
+    return get();
   }
 
   T& operator * () const {
-    return *elem.lock().get();
+    return *get();
   }
 
   explicit operator bool() const {
-    return !!elem.lock();
+    return !!get();
   }
 
   bool operator !() const {
-    return !elem.lock();
+    return !get();
   }
 
   template <typename U>
@@ -163,23 +167,28 @@ class WeakPointer {
   }
 
   bool operator == (std::nullptr_t) const {
-    return !elem.lock();
+    return !get();
   }
 
   bool operator != (std::nullptr_t) const {
-    return !!elem.lock();
+    return !!get();
   }
 
+  // Checking expiry only reads the reference count, unlike lock(), which has to update it twice
   T* get() const {
-    return elem.lock().get();
+    return elem.expired() ? nullptr : ptr;
   }
 
   int getHash() const {
-    auto sp = elem.lock();
-    return std::hash<decltype(sp)>()(sp);
+    return std::hash<T*>()(get());
   }
 
-  SERIALIZE_ALL(elem)
+  template <class Archive>
+  void serialize(Archive& ar1, const unsigned int) {
+    ar1(elem);
+    if (Archive::is_loading::value)
+      ptr = elem.lock().get();
+  }
 
   private:
   template<class U>
@@ -189,9 +198,10 @@ class WeakPointer {
   friend class OwnerPointer;
   template <typename>
   friend class WeakPointer;
-  WeakPointer(const shared_ptr<T>& e) : elem(e) {}
+  WeakPointer(const shared_ptr<T>& e) : elem(e), ptr(e.get()) {}
 
   weak_ptr<T> SERIAL(elem);
+  T* ptr = nullptr;
 };
 
 template<typename T>
@@ -237,9 +247,22 @@ T* OwnerPointer<T>::get() const {
   return elem.get();
 }
 
+namespace owner_pointer {
+template <typename T, typename... Args>
+shared_ptr<T> makeShared(std::true_type, Args&&... args) {
+  return std::allocate_shared<T>(PoolAllocator<T>(), std::forward<Args>(args)...);
+}
+
+template <typename T, typename... Args>
+shared_ptr<T> makeShared(std::false_type, Args&&... args) {
+  return std::make_shared<T>(std::forward<Args>(args)...);
+}
+}
+
 template <typename T, typename... Args>
 OwnerPointer<T> makeOwner(Args&&... args) {
-  return OwnerPointer<T>(std::make_shared<T>(std::forward<Args>(args)...));
+  return OwnerPointer<T>(owner_pointer::makeShared<T>(std::is_base_of<PoolAllocated, T>(),
+      std::forward<Args>(args)...));
 }
 
 template<class T>
@@ -7,6 +7,8 @@
 
 typedef StreamCombiner<ogzstream, OutputArchive> CompressedOutput;
 typedef StreamCombiner<igzstream, InputArchive> CompressedInput;
+typedef StreamCombiner<ofstream, OutputArchive> UncompressedOutput;
+typedef StreamCombiner<ifstream, InputArchive> UncompressedInput;
 
 template <typename InputType>
 optional<pair<string, int>> getNameAndVersionUsing(const FilePath& filename) {
@@ -42,4 +44,46 @@ inline optional<SavedGameInfo> getSavedGameInfo(const FilePath& filename) {
   return getSavedGameInfoUsing<CompressedInput>(filename);
 }
 
+struct SaveFileHeader {
+  int SERIAL(version);
+  string SERIAL(name);
+  SavedGameInfo SERIAL(info);
+  SERIALIZE_ALL(version, name, info)
+};
 
+// A copy of the save header is kept uncompressed in a small file next to the save, so menus can list saves
+// without inflating them. It's tied to the save by its modification time and recreated when it's stale.
+inline FilePath getSaveHeaderPath(const FilePath& save) {
+  return FilePath::fromFullPath(save.getPath() + string(".info"));
+}
+
+inline void writeSaveHeader(const FilePath& save, const SaveFileHeader& header) {
+  try {
+    UncompressedOutput output(getSaveHeaderPath(save).getPath(), std::ios::binary);
+    output.getArchive() << save.getModificationTime() << header;
+  } catch (std::exception&) {
+    // The header is only a cache, reading it will fall back to the save.
+  }
+}
+
+inline optional<SaveFileHeader> getSaveHeader(const FilePath& save) {
+  try {
+    UncompressedInput input(getSaveHeaderPath(save).getPath(), std::ios::binary);
+    time_t saveTime;
+    SaveFileHeader ret;
+    input.getArchive() >> saveTime;
+    if (saveTime == save.getModificationTime()) {
+      input.getArchive() >> ret;
+      return ret;
+    }
+  } catch (std::exception&) {}
+  try {
+    CompressedInput input(save.getPath());
+    SaveFileHeader ret;
+    input.getArchive() >> ret.version >> ret.name >> ret.info;
+    writeSaveHeader(save, ret);
+    return ret;
+  } catch (std::exception&) {
+    return none;
+  }
+}
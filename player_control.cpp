@@ -88,6 +88,7 @@
 #include "campaign.h"
 #include "game_event.h"
 #include "view_object_action.h"
+#include "memory_report.h"
 
 template <class Archive>
 void PlayerControl::serialize(Archive& ar, const unsigned int version) {
@@ -1396,7 +1397,9 @@ void PlayerControl::refreshGameInfo(GameInfo& gameInfo) const {
     tutorial->refreshInfo(getGame(), gameInfo.tutorial);
   gameInfo.singleModel = getGame()->isSingleModel();
   gameInfo.villageInfo.villages.clear();
-  gameInfo.villageInfo.numMainVillains = gameInfo.villageInfo.numConqueredMainVillains = 0;
+  gameInfo.villageInfo.numConqueredMainVillains = getGame()->getNumConqueredLazyVillains(VillainType::MAIN);
+  gameInfo.villageInfo.numMainVillains = getGame()->getNumLazyVillains(VillainType::MAIN) +
+      gameInfo.villageInfo.numConqueredMainVillains;
   for (auto& col : getGame()->getVillains(VillainType::MAIN)) {
     ++gameInfo.villageInfo.numMainVillains;
     if (col->isConquered())
@@ -1555,7 +1558,8 @@ void PlayerControl::onEvent(const GameEvent& event) {
       },
       [&](const RetiredGame&) {
         if (auto keeper = getKeeper()) // Check if keeper is alive just in case. If he's not then game over has already happened
-          if (getGame()->getVillains(VillainType::MAIN).empty())
+          if (getGame()->getVillains(VillainType::MAIN).empty() &&
+              getGame()->getNumLazyVillains(VillainType::MAIN) == 0)
             // No victory condition in this game, so we generate a highscore when retiring.
             getGame()->retired(keeper->getName().firstOrBare(), collective->getKills().getSize(),
                 (int) collective->getDangerLevel() + collective->getPoints());
@@ -2295,6 +2299,15 @@ void PlayerControl::processInput(View* view, UserInput input) {
     case UserInputId::RELOAD_DATA:
       reloadData();
       break;
+    case UserInputId::MEMORY_REPORT: {
+      MemoryReport report("Game");
+      getGame()->addMemoryUsage(report);
+      stringstream text;
+      report.print(text, 3);
+      INFO << text.str();
+      getView()->presentText("Memory usage", text.str());
+      break;
+    }
     case UserInputId::TUTORIAL_CONTINUE:
       if (tutorial)
         tutorial->continueTutorial(getGame());
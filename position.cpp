@@ -429,7 +429,7 @@ PItem Position::removeItem(WItem it) const {
 Inventory& Position::modInventory() const {
   PROFILE;
   if (!isValid()) {
-    static Inventory empty;
+    static thread_local Inventory empty;
     return empty;
   } else
     return modSquare()->getInventory();
@@ -587,7 +587,7 @@ void Position::removeFurniture(WConstFurniture f, PFurniture replace) const {
     level->setFurniture(coord, std::move(replace));
   else {
     level->furniture->getBuilt(layer).clearElem(coord);
-    level->furniture->getConstruction(coord, layer).reset();
+    level->furniture->clearConstruction(coord, layer);
   }
   updateMovementDueToFire();
   updateConnectivity();
@@ -642,7 +642,8 @@ bool Position::construct(FurnitureType type, TribeId tribe) {
 
 bool Position::isActiveConstruction(FurnitureLayer layer) const {
   PROFILE;
-  return !isUnavailable() && !!level->furniture->getConstruction(coord, layer);
+  const FurnitureArray& furniture = *level->furniture;
+  return !isUnavailable() && !!furniture.getConstruction(coord, layer);
 }
 
 bool Position::isBurning() const {
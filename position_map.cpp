@@ -9,6 +9,7 @@
 #include "furniture_layer.h"
 #include "construction_map.h"
 #include "zones.h"
+#include "memory_report.h"
 
 template <typename T>
 static optional<T&> getReferenceOptional(optional<T>& t) {
@@ -161,6 +162,16 @@ void PositionMap<T>::limitToModel(const WModel m) {
       outliers.erase(elem.first);
 }
 
+template <class T>
+long long PositionMap<T>::getMemoryUsage() const {
+  long long ret = MemoryReport::getSize(tables) + MemoryReport::getSize(outliers);
+  for (auto& table : tables)
+    ret += MemoryReport::getSize(table.second);
+  for (auto& level : outliers)
+    ret += MemoryReport::getSize(level.second);
+  return ret;
+}
+
 template <class T>
 template <class Archive> 
 void PositionMap<T>::serialize(Archive& ar, const unsigned int version) {
@@ -0,0 +1,208 @@
+#include "stdafx.h"
+#include "profiler.h"
+#include <iomanip>
+
+std::atomic<bool> Profiler::enabled(false);
+
+namespace {
+struct Event {
+  const char* name;
+  long long start;
+  long long end;
+};
+
+struct ThreadBuffer {
+  static constexpr int size = 1 << 16;
+  // Taken by the owning thread for every event, so it's only contended while summing up or writing a trace
+  std::mutex mutex;
+  std::vector<Event> events;
+  long long numWritten = 0;
+  long long numRead[2] = {0, 0};
+  int threadId;
+  bool finished = false;
+};
+
+struct Stats {
+  int numCalls = 0;
+  long long nanos = 0;
+};
+}
+
+static std::mutex globalMutex;
+static std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+static int numThreads = 0;
+static Profiler::Summary lastSummary[2];
+static long long periodStart[2] = {0, 0};
+static long long traceStart = 0;
+// Buffers of threads that finished are kept for the trace, but only a few of them
+static const int maxFinishedBuffers = 8;
+
+namespace {
+struct BufferHolder {
+  std::shared_ptr<ThreadBuffer> buffer;
+  ~BufferHolder() {
+    if (buffer) {
+      std::lock_guard<std::mutex> lock(globalMutex);
+      buffer->finished = true;
+      int numFinished = 0;
+      for (int i = buffers.size() - 1; i >= 0; --i)
+        if (buffers[i]->finished && ++numFinished > maxFinishedBuffers)
+          buffers.erase(buffers.begin() + i);
+    }
+  }
+};
+}
+
+static thread_local BufferHolder bufferHolder;
+
+void Profiler::setEnabled(bool state) {
+  if (state && !traceStart)
+    traceStart = getTime();
+  enabled = state;
+}
+
+long long Profiler::getTime() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void Profiler::record(const char* name, long long start, long long end) {
+  auto& buffer = bufferHolder.buffer;
+  if (!buffer) {
+    buffer = std::make_shared<ThreadBuffer>();
+    buffer->events.resize(ThreadBuffer::size);
+    std::lock_guard<std::mutex> lock(globalMutex);
+    buffer->threadId = ++numThreads;
+    buffers.push_back(buffer);
+  }
+  std::lock_guard<std::mutex> lock(buffer->mutex);
+  buffer->events[buffer->numWritten % ThreadBuffer::size] = Event{name, start, end};
+  ++buffer->numWritten;
+}
+
+// Function names from __PRETTY_FUNCTION__ are shortened to the qualified name, without the return type
+// and the arguments
+static std::string getDisplayName(const char* name) {
+  std::string ret = name;
+  auto end = ret.find('(');
+  if (end == std::string::npos || end == 0)
+    return ret;
+  int depth = 0;
+  int begin = end - 1;
+  for (; begin >= 0; --begin) {
+    if (ret[begin] == '>')
+      ++depth;
+    else if (ret[begin] == '<')
+      --depth;
+    else if (ret[begin] == ' ' && depth == 0)
+      break;
+  }
+  return ret.substr(begin + 1, end - begin - 1);
+}
+
+static const std::string& getCachedDisplayName(const char* name) {
+  static std::unordered_map<const char*, std::string> cache;
+  auto it = cache.find(name);
+  if (it != cache.end())
+    return it->second;
+  return cache[name] = getDisplayName(name);
+}
+
+void Profiler::markEnd(ProfilerPeriod period) {
+  if (!isEnabled())
+    return;
+  int index = int(period);
+  auto now = getTime();
+  std::lock_guard<std::mutex> lock(globalMutex);
+  std::unordered_map<const char*, Stats> stats;
+  Summary summary;
+  for (auto& buffer : buffers) {
+    std::lock_guard<std::mutex> bufferLock(buffer->mutex);
+    long long first = std::max(buffer->numRead[index], buffer->numWritten - ThreadBuffer::size);
+    summary.numDropped += first - buffer->numRead[index];
+    for (long long i = first; i < buffer->numWritten; ++i) {
+      auto& event = buffer->events[i % ThreadBuffer::size];
+      auto& elem = stats[event.name];
+      ++elem.numCalls;
+      elem.nanos += event.end - event.start;
+    }
+    buffer->numRead[index] = buffer->numWritten;
+  }
+  // Functions with the same shortened name, like overloads, are summed up together
+  std::unordered_map<std::string, Entry> entries;
+  for (auto& elem : stats) {
+    auto& name = getCachedDisplayName(elem.first);
+    auto& entry = entries[name];
+    entry.name = name;
+    entry.numCalls += elem.second.numCalls;
+    entry.micros += elem.second.nanos / 1000;
+  }
+  for (auto& elem : entries)
+    summary.entries.push_back(elem.second);
+  std::sort(summary.entries.begin(), summary.entries.end(),
+      [](const Entry& e1, const Entry& e2) { return e1.micros > e2.micros; });
+  if (periodStart[index] > 0)
+    summary.micros = (now - periodStart[index]) / 1000;
+  periodStart[index] = now;
+  lastSummary[index] = std::move(summary);
+}
+
+Profiler::Summary Profiler::getLastSummary(ProfilerPeriod period) {
+  std::lock_guard<std::mutex> lock(globalMutex);
+  return lastSummary[int(period)];
+}
+
+std::vector<std::string> Profiler::getOverlayText(int maxEntries) {
+  std::vector<std::string> ret;
+  for (auto period : {ProfilerPeriod::FRAME, ProfilerPeriod::TURN}) {
+    auto summary = getLastSummary(period);
+    std::stringstream header;
+    header << (period == ProfilerPeriod::FRAME ? "Last frame: " : "Last turn: ") << summary.micros / 1000 << "ms";
+    if (summary.numDropped > 0)
+      header << ", " << summary.numDropped << " timings dropped";
+    ret.push_back(header.str());
+    for (int i = 0; i < std::min<int>(maxEntries, summary.entries.size()); ++i) {
+      auto& entry = summary.entries[i];
+      std::stringstream line;
+      line << "  " << entry.micros / 1000 << "." << entry.micros % 1000 / 100 << "ms " << entry.numCalls << "x "
+          << entry.name;
+      ret.push_back(line.str());
+    }
+  }
+  return ret;
+}
+
+static void writeJsonString(std::ostream& out, const std::string& s) {
+  out << '"';
+  for (char c : s) {
+    if (c == '"' || c == '\\')
+      out << '\\';
+    out << c;
+  }
+  out << '"';
+}
+
+void Profiler::writeChromeTrace(std::ostream& out) {
+  std::lock_guard<std::mutex> lock(globalMutex);
+  auto flags = out.flags();
+  auto precision = out.precision();
+  out << std::fixed << std::setprecision(3) << "{\"traceEvents\":[";
+  bool first = true;
+  for (auto& buffer : buffers) {
+    std::lock_guard<std::mutex> bufferLock(buffer->mutex);
+    for (long long i = std::max(0LL, buffer->numWritten - ThreadBuffer::size); i < buffer->numWritten; ++i) {
+      auto& event = buffer->events[i % ThreadBuffer::size];
+      if (!first)
+        out << ",\n";
+      first = false;
+      out << "{\"name\":";
+      writeJsonString(out, getCachedDisplayName(event.name));
+      // Times are in microseconds since the profiler was first enabled
+      out << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->threadId << ",\"ts\":"
+          << double(event.start - traceStart) / 1000 << ",\"dur\":" << double(event.end - event.start) / 1000 << "}";
+    }
+  }
+  out << "]}\n";
+  out.flags(flags);
+  out.precision(precision);
+}
@@ -1,5 +1,77 @@
 #pragma once
 
+#include <atomic>
+#include <ostream>
+#include <string>
+#include <vector>
+
+enum class ProfilerPeriod { FRAME, TURN };
+
+// Built-in profiler that records scoped timings into a ring buffer per thread, while it's enabled.
+// Timings are summed per frame and per game turn, and the recent ones can be written as a Chrome trace,
+// which can be opened in chrome://tracing or Perfetto.
+class Profiler {
+  public:
+  static void setEnabled(bool);
+  static bool isEnabled() {
+    return enabled.load(std::memory_order_relaxed);
+  }
+
+  class Scope {
+    public:
+    Scope(const char* name) : name(isEnabled() ? name : nullptr) {
+      if (this->name)
+        start = getTime();
+    }
+
+    // Extra arguments are accepted for compatibility with EASY_BLOCK and ignored
+    template <typename... Args>
+    Scope(const char* name, const Args&...) : Scope(name) {}
+
+    ~Scope() {
+      if (name)
+        record(name, start, getTime());
+    }
+
+    private:
+    const char* name;
+    long long start;
+  };
+
+  // Sums up the timings that ended since the previous call for the same period
+  static void markEnd(ProfilerPeriod);
+
+  struct Entry {
+    std::string name;
+    int numCalls;
+    long long micros;
+  };
+  struct Summary {
+    std::vector<Entry> entries;
+    long long micros = 0;
+    long long numDropped = 0;
+  };
+  // Entries are sorted by time, which includes the time of nested scopes
+  static Summary getLastSummary(ProfilerPeriod);
+  static std::vector<std::string> getOverlayText(int maxEntries);
+
+  static void writeChromeTrace(std::ostream&);
+
+  private:
+  static std::atomic<bool> enabled;
+  static long long getTime();
+  static void record(const char* name, long long start, long long end);
+};
+
+#define PROFILE_CONCAT2(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT2(a, b)
+
+#ifdef __GNUC__
+#define PROFILE_FUNCTION_NAME __PRETTY_FUNCTION__
+#else
+#define PROFILE_FUNCTION_NAME __FUNCTION__
+#endif
+
 #ifdef EASY_PROFILER
 #define BUILD_WITH_EASY_PROFILER
 
@@ -15,8 +87,9 @@
 
 #else
 
-#define PROFILE
-#define PROFILE_BLOCK(...)
+// Like EASY_FUNCTION, ends with a semicolon, because some uses leave it out
+#define PROFILE Profiler::Scope PROFILE_CONCAT(profilerScope, __LINE__)(PROFILE_FUNCTION_NAME);
+#define PROFILE_BLOCK(...) Profiler::Scope PROFILE_CONCAT(profilerBlock, __LINE__)(__VA_ARGS__)
 #define ENABLE_PROFILER
 
 #endif
@@ -1,80 +1,124 @@
 #pragma once
 
 #include "util.h"
+#include "chunked_table.h"
+#include "memory_report.h"
 
+// Every tile is empty, shares a readonly prototype with all tiles of the same Param, or owns a modified copy.
+// Prototypes and their Params are kept in flat arrays, and a tile gets a copy of its own only when it's written
+// to. Both cases fit in one index per tile, so a pristine map costs one int per tile and one object per Param.
 template <typename Type, typename Param, typename Generator>
 class ReadWriteArray {
   public:
   typedef OwnerPointer<Type> PType;
   typedef Type* WType;
 
-  ReadWriteArray(Rectangle bounds) : modified(bounds, -1), readonly(bounds, -1), types(bounds) {}
+  ReadWriteArray(Rectangle bounds) : indexes(bounds, int(empty)) {}
 
   const Rectangle& getBounds() const {
-    return modified.getBounds();
+    return indexes.getBounds();
   }
 
   WType getWritable(Vec2 pos) {
-    if (modified[pos] == -1)
-      if (auto type = types[pos])
-        putElem(pos, Generator()(*type));
-    if (modified[pos] > -1)
-      return allModified[modified[pos]].get();
+    int index = indexes[pos];
+    if (index < empty) {
+      putElem(pos, Generator()(params[getReadonlyIndex(index)]));
+      index = indexes[pos];
+    }
+    if (index > empty)
+      return allModified[index].get();
     else
       return nullptr;
   }
 
   const WType getReadonly(Vec2 pos) const {
-    if (readonly[pos] > -1)
-      return allReadonly[readonly[pos]].get();
-    else if (modified[pos] > -1)
-      return allModified[modified[pos]].get();
+    int index = indexes[pos];
+    if (index > empty)
+      return allModified[index].get();
+    else if (index < empty)
+      return allReadonly[getReadonlyIndex(index)].get();
     else
       return nullptr;
   }
 
   void putElem(Vec2 pos, Param param) {
+    // The lookup isn't serialized, it's rebuilt when the first element is put after loading
+    if (readonlyMap.size() < params.size())
+      for (int i : All(params))
+        readonlyMap.insert(make_pair(params[i], i));
     if (!readonlyMap.count(param)) {
       allReadonly.push_back(Generator()(param));
-      CHECK(allReadonly.size() < 30000);
+      params.push_back(param);
       readonlyMap.insert(make_pair(param, allReadonly.size() - 1));
     }
-    readonly[pos] = readonlyMap.at(param);
-    modified[pos] = -1;
-    types[pos] = param;
+    indexes.getWritable(pos) = empty - 1 - readonlyMap.at(param);
   }
 
   void putElem(Vec2 pos, PType s) {
     allModified.push_back(std::move(s));
-    CHECK(allModified.size() < 30000);
-    modified[pos] = allModified.size() - 1;
-    readonly[pos] = -1;
+    indexes.getWritable(pos) = allModified.size() - 1;
   }
 
   void clearElem(Vec2 pos) {
-    types[pos] = none;
-    modified[pos] = -1;
-    readonly[pos] = -1;
+    if (indexes[pos] != empty)
+      indexes.getWritable(pos) = empty;
+  }
+
+  struct Snapshot {
+    ChunkedTable<int> indexes;
+    int numModified;
+  };
+
+  /** Saves which element is where. Elements created after the snapshot are dropped by restore().*/
+  Snapshot getSnapshot() const {
+    return Snapshot{indexes, allModified.size()};
+  }
+
+  void restore(Snapshot snapshot) {
+    indexes = std::move(snapshot.indexes);
+    allModified.resize(snapshot.numModified);
   }
 
   int getNumGenerated() const {
-    return allModified.size() + readonlyMap.size();
+    return allModified.size() + allReadonly.size();
   }
 
   int getNumTotal() const {
     return 0;
   }
 
-  SERIALIZE_ALL(modified, allModified, allReadonly, readonly, types, readonlyMap, numTotal)
+  long long getMemoryUsage() const {
+    return indexes.getMemoryUsage() + (long long) (allModified.size() + allReadonly.size()) * sizeof(Type) +
+        MemoryReport::getSize(allModified) + MemoryReport::getSize(allReadonly) + MemoryReport::getSize(params) +
+        MemoryReport::getSize(readonlyMap);
+  }
+
+  template <class Archive>
+  void save(Archive& ar, const unsigned int) const {
+    ar(allModified, allReadonly, indexes);
+    saveArray(ar, params.data(), params.size());
+  }
+
+  template <class Archive>
+  void load(Archive& ar, const unsigned int) {
+    ar(allModified, allReadonly, indexes);
+    params.resize(allReadonly.size());
+    loadArray(ar, params.data(), params.size());
+  }
+
   SERIALIZATION_CONSTRUCTOR(ReadWriteArray)
 
   private:
-  vector<PType> SERIAL(allModified);
-  Table<short> SERIAL(modified);
-  vector<PType> SERIAL(allReadonly);
-  Table<short> SERIAL(readonly);
-  Table<optional<Param>> SERIAL(types);
-  unordered_map<Param, short, CustomHash<Param>> SERIAL(readonlyMap);
-  int SERIAL(numTotal) = 0;
-};
+  static constexpr int empty = -1;
+
+  static int getReadonlyIndex(int index) {
+    return empty - 1 - index;
+  }
 
+  vector<PType> allModified;
+  vector<PType> allReadonly;
+  vector<Param> params;
+  // Non-negative values index allModified, values below empty index allReadonly and params
+  ChunkedTable<int> indexes;
+  unordered_map<Param, int, CustomHash<Param>> readonlyMap;
+};
@@ -512,14 +512,37 @@ void Renderer::drawAsciiBackground(ViewId id, Rectangle bounds) {
 }
 
 void Renderer::loadTiles() {
-  tiles.clear();
+  decodeTiles();
+  uploadTiles();
+}
+
+void Renderer::decodeTiles() {
+  CHECK(decodedTiles.empty() && decodedAnimations.empty());
   tileCoords.clear();
-  for (auto& dir : tileDirectories)
-    loadTilesFromDir(dir.path, dir.size, 720);
+  for (int i : All(tileDirectories))
+    decodedTiles.push_back(decodeTilesFromDir(tileDirectories[i].path, tileDirectories[i].size, 720, i));
   if (animationDirectory) {
-    for (auto id : ENUM_ALL(AnimationId))
-      animations[id] = AnimationInfo { Texture(animationDirectory->file(getFileName(id))), getNumFrames(id)};
+    for (auto id : ENUM_ALL(AnimationId)) {
+      auto path = animationDirectory->file(getFileName(id));
+      SDL::SDL_Surface* image = SDL::IMG_Load(path.getPath());
+      CHECK(image) << path << ": " << SDL::IMG_GetError();
+      decodedAnimations.push_back(make_pair(id, image));
+    }
+  }
+}
+
+void Renderer::uploadTiles() {
+  tiles.clear();
+  for (auto surface : decodedTiles) {
+    tiles.push_back(Texture(surface));
+    SDL::SDL_FreeSurface(surface);
+  }
+  decodedTiles.clear();
+  for (auto& elem : decodedAnimations) {
+    animations[elem.first] = AnimationInfo { Texture(elem.second), getNumFrames(elem.first)};
+    SDL::SDL_FreeSurface(elem.second);
   }
+  decodedAnimations.clear();
 }
 
 void Renderer::addTilesDirectory(const DirectoryPath& path, Vec2 size) {
@@ -530,7 +553,7 @@ void Renderer::setAnimationsDirectory(const DirectoryPath& path) {
   animationDirectory = path;
 }
 
-void Renderer::loadTilesFromDir(const DirectoryPath& path, Vec2 size, int setWidth) {
+SDL::SDL_Surface* Renderer::decodeTilesFromDir(const DirectoryPath& path, Vec2 size, int setWidth, int texNum) {
   const static string imageSuf = ".png";
   auto files = path.getFiles().filter([](const FilePath& f) { return f.hasSuffix(imageSuf);});
   int rowLength = setWidth / size.x;
@@ -559,14 +582,13 @@ void Renderer::loadTilesFromDir(const DirectoryPath& path, Vec2 size, int setWid
       src.w = size.x;
       src.h = size.y;
       SDL_BlitSurface(im, &src, image, &dest);
-      tileCoords[spriteName].push_back({{posX, posY}, int(tiles.size())});
+      tileCoords[spriteName].push_back({{posX, posY}, texNum});
       INFO << "Loading tile sprite " << fileName << " at " << posX << "," << posY;
       ++frameCount;
     }
     SDL::SDL_FreeSurface(im);
   }
-  tiles.push_back(Texture(image));
-  SDL::SDL_FreeSurface(image);
+  return image;
 }
 
 const vector<Renderer::TileCoord>& Renderer::getTileCoord(const string& name) {
@@ -130,6 +130,10 @@ class Renderer {
   void addTilesDirectory(const DirectoryPath&, Vec2 size);
   void setAnimationsDirectory(const DirectoryPath&);
   void loadTiles();
+  // Reads and composes all tile images. Doesn't touch OpenGL, so it can be run on any thread.
+  void decodeTiles();
+  // Creates the textures from decoded tiles. Must be called on the rendering thread.
+  void uploadTiles();
   void makeScreenshot(const FilePath&);
   void renderDeferredSprites();
 
@@ -188,7 +192,9 @@ class Renderer {
   };
   vector<DeferredSprite> deferredSprites;
   vector<Rectangle> scissorStack;
-  void loadTilesFromDir(const DirectoryPath&, Vec2 size, int setWidth);
+  SDL::SDL_Surface* decodeTilesFromDir(const DirectoryPath&, Vec2 size, int setWidth, int texNum);
+  vector<SDL::SDL_Surface*> decodedTiles;
+  vector<pair<AnimationId, SDL::SDL_Surface*>> decodedAnimations;
   struct TileDirectory {
     DirectoryPath path;
     Vec2 size;
@@ -0,0 +1,227 @@
+#pragma once
+
+#include "logging_view.h"
+
+// Plays a game recorded with LoggingView: returns the recorded input and time instead of asking the delegate,
+// which is only used to show the game. When the recording runs out, all calls go to the delegate.
+class ReplayView : public View {
+  public:
+  // With stopBeforeExit the replay finishes before the recorded exit from the game, so that the game isn't saved.
+  ReplayView(InputArchive& a, View* d, bool stop) : archive(a), delegate(d), stopBeforeExit(stop) {}
+
+  bool isFinished() const {
+    return finished;
+  }
+
+  virtual void initialize(unique_ptr<fx::FXRenderer>, unique_ptr<FXViewManager>) override;
+
+  virtual void reset() override {
+    delegate->reset();
+  }
+
+  virtual void displaySplash(const ProgressMeter* meter, const string& text, SplashType type,
+      function<void()> cancelFun = nullptr) override {
+    delegate->displaySplash(meter, text, type, cancelFun);
+  }
+
+  virtual void clearSplash() override {
+    delegate->clearSplash();
+  }
+
+  virtual void close() override {
+    delegate->close();
+  }
+
+  virtual void refreshView() override {
+    delegate->refreshView();
+  }
+
+  virtual double getGameSpeed() override {
+    return replay(ViewCall::GAME_SPEED, [&] { return delegate->getGameSpeed(); });
+  }
+
+  virtual void updateView(CreatureView* creatureView, bool noRefresh) override {
+    delegate->updateView(creatureView, noRefresh);
+  }
+
+  virtual void drawLevelMap(const CreatureView* creatureView) override {
+    delegate->drawLevelMap(creatureView);
+  }
+
+  virtual void setScrollPos(Vec2 pos) override {
+    delegate->setScrollPos(pos);
+  }
+
+  virtual void resetCenter() override {
+    delegate->resetCenter();
+  }
+
+  virtual UserInput getAction() override {
+    auto ret = replay(ViewCall::ACTION, [&] { return delegate->getAction(); });
+    if (stopBeforeExit && !finished && ret.getId() == UserInputId::EXIT) {
+      finished = true;
+      return delegate->getAction();
+    }
+    return ret;
+  }
+
+  virtual bool travelInterrupt() override {
+    return replay(ViewCall::TRAVEL_INTERRUPT, [&] { return delegate->travelInterrupt(); });
+  }
+
+  virtual optional<int> chooseFromList(const string& title, const vector<ListElem>& options, int index = 0,
+      MenuType type = MenuType::NORMAL, ScrollPosition* scrollPos = nullptr,
+      optional<UserInputId> exitAction = none) override {
+    return replay(ViewCall::CHOOSE_FROM_LIST,
+        [&] { return delegate->chooseFromList(title, options, index, type, scrollPos, exitAction); });
+  }
+
+  virtual optional<Vec2> chooseDirection(Vec2 playerPos, const string& message) override {
+    return replay(ViewCall::CHOOSE_DIRECTION, [&] { return delegate->chooseDirection(playerPos, message); });
+  }
+
+  virtual optional<Vec2> chooseTarget(Vec2 playerPos, Table<PassableInfo> passable, const string& message) override {
+    return replay(ViewCall::CHOOSE_TARGET,
+        [&] { return delegate->chooseTarget(playerPos, std::move(passable), message); });
+  }
+
+  virtual bool yesOrNoPrompt(const string& message, bool defaultNo = false) override {
+    return replay(ViewCall::YES_OR_NO, [&] { return delegate->yesOrNoPrompt(message, defaultNo); });
+  }
+
+  virtual void presentText(const string& title, const string& text) override {
+    delegate->presentText(title, text);
+  }
+
+  virtual void presentList(const string& title, const vector<ListElem>& options, bool scrollDown = false,
+      MenuType type = MenuType::NORMAL, optional<UserInputId> exitAction = none) override {
+    delegate->presentList(title, options, scrollDown, type, exitAction);
+  }
+
+  virtual optional<int> getNumber(const string& title, Range range, int initial, int increments = 1) override {
+    return replay(ViewCall::NUMBER, [&] { return delegate->getNumber(title, range, initial, increments); });
+  }
+
+  virtual optional<string> getText(const string& title, const string& value, int maxLength,
+      const string& hint = "") override {
+    return replay(ViewCall::TEXT, [&] { return delegate->getText(title, value, maxLength, hint); });
+  }
+
+  virtual optional<UniqueEntity<Item>::Id> chooseTradeItem(const string& title, pair<ViewId, int> budget,
+      const vector<ItemInfo>& items, ScrollPosition* scrollPos) override {
+    return replay(ViewCall::TRADE_ITEM, [&] { return delegate->chooseTradeItem(title, budget, items, scrollPos); });
+  }
+
+  virtual optional<int> choosePillageItem(const string& title, const vector<ItemInfo>& items,
+      ScrollPosition* scrollPos) override {
+    return replay(ViewCall::PILLAGE_ITEM, [&] { return delegate->choosePillageItem(title, items, scrollPos); });
+  }
+
+  virtual optional<int> chooseItem(const vector<ItemInfo>& items, ScrollPosition* scrollPos) override {
+    return replay(ViewCall::ITEM, [&] { return delegate->chooseItem(items, scrollPos); });
+  }
+
+  virtual optional<int> chooseAtMouse(const vector<string>& elems) override {
+    return replay(ViewCall::AT_MOUSE, [&] { return delegate->chooseAtMouse(elems); });
+  }
+
+  virtual void presentHighscores(const vector<HighscoreList>& highscores) override {
+    delegate->presentHighscores(highscores);
+  }
+
+  virtual void setBugReportSaveCallback(BugReportSaveCallback callback) override {
+    delegate->setBugReportSaveCallback(callback);
+  }
+
+  virtual variant<AvatarChoice, AvatarMenuOption> chooseAvatar(const vector<AvatarData>& avatars,
+      Options* options) override {
+    return delegate->chooseAvatar(avatars, options);
+  }
+
+  virtual CampaignAction prepareCampaign(CampaignOptions campaignOptions, Options* options,
+      CampaignMenuState& state) override {
+    return delegate->prepareCampaign(campaignOptions, options, state);
+  }
+
+  virtual optional<UniqueEntity<Creature>::Id> chooseCreature(const string& title,
+      const vector<CreatureInfo>& creatures, const string& cancelText) override {
+    return replay(ViewCall::CREATURE, [&] { return delegate->chooseCreature(title, creatures, cancelText); });
+  }
+
+  virtual bool creatureInfo(const string& title, bool prompt, const vector<CreatureInfo>& creatures) override {
+    return replay(ViewCall::CREATURE_INFO, [&] { return delegate->creatureInfo(title, prompt, creatures); });
+  }
+
+  virtual optional<Vec2> chooseSite(const string& message, const Campaign& campaign,
+      optional<Vec2> current = none) override {
+    return replay(ViewCall::SITE, [&] { return delegate->chooseSite(message, campaign, current); });
+  }
+
+  virtual void presentWorldmap(const Campaign& campaign) override {
+    delegate->presentWorldmap(campaign);
+  }
+
+  virtual void animateObject(Vec2 begin, Vec2 end, optional<ViewId> object, optional<FXInfo> fx) override {
+    delegate->animateObject(begin, end, object, fx);
+  }
+
+  virtual void animation(Vec2 pos, AnimationId id, Dir orientation = Dir::N) override {
+    delegate->animation(pos, id, orientation);
+  }
+
+  virtual void animation(const FXSpawnInfo& info) override {
+    delegate->animation(info);
+  }
+
+  virtual milliseconds getTimeMilli() override {
+    return milliseconds{replay(ViewCall::TIME, [&] { return (long long) delegate->getTimeMilli().count(); })};
+  }
+
+  virtual milliseconds getTimeMilliAbsolute() override {
+    return milliseconds{
+        replay(ViewCall::ABSOLUTE_TIME, [&] { return (long long) delegate->getTimeMilliAbsolute().count(); })};
+  }
+
+  virtual void stopClock() override {
+    delegate->stopClock();
+  }
+
+  virtual void continueClock() override {
+    delegate->continueClock();
+  }
+
+  virtual bool isClockStopped() override {
+    return replay(ViewCall::CLOCK_STOPPED, [&] { return delegate->isClockStopped(); });
+  }
+
+  virtual void addSound(const Sound& sound) override {
+    delegate->addSound(sound);
+  }
+
+  virtual void logMessage(const string& message) override {
+    delegate->logMessage(message);
+  }
+
+  private:
+  template <typename Fun>
+  auto replay(ViewCall call, Fun live) -> decltype(live()) {
+    if (!finished)
+      try {
+        ViewCall recorded;
+        archive >> recorded;
+        CHECK(recorded == call) << "Replay diverged from the recording, expected call " << int(recorded)
+            << ", got " << int(call);
+        decltype(live()) ret;
+        archive >> ret;
+        return ret;
+      } catch (cereal::Exception&) {
+        finished = true;
+      }
+    return live();
+  }
+
+  InputArchive& archive;
+  View* delegate;
+  bool stopBeforeExit;
+  bool finished = false;
+};
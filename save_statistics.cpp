@@ -0,0 +1,103 @@
+#include "stdafx.h"
+#include "save_statistics.h"
+
+#ifdef __GNUC__
+#include <cxxabi.h>
+#endif
+
+static thread_local SaveStatistics* current = nullptr;
+
+SaveStatistics::SaveStatistics() : stream(&buffer), previous(current) {
+  current = this;
+}
+
+SaveStatistics::~SaveStatistics() {
+  current = previous;
+}
+
+SaveStatistics* SaveStatistics::getCurrent() {
+  return current;
+}
+
+std::streamsize SaveStatistics::CountingBuffer::xsputn(const char*, std::streamsize n) {
+  count += n;
+  return n;
+}
+
+SaveStatistics::CountingBuffer::int_type SaveStatistics::CountingBuffer::overflow(int_type c) {
+  if (!traits_type::eq_int_type(c, traits_type::eof()))
+    ++count;
+  return traits_type::not_eof(c);
+}
+
+std::ostream& SaveStatistics::getStream() {
+  return stream;
+}
+
+long long SaveStatistics::getTotalBytes() const {
+  return buffer.count;
+}
+
+void SaveStatistics::enter(const std::type_info& type) {
+  auto& info = types[std::type_index(type)];
+  ++info.count;
+  ++info.depth;
+  stack.push_back(Frame{&info, buffer.count, 0});
+}
+
+void SaveStatistics::exit() {
+  auto frame = stack.back();
+  stack.pop_back();
+  long long bytes = buffer.count - frame.start;
+  frame.type->selfBytes += bytes - frame.childBytes;
+  // Types nested in themselves are only counted at the outermost level
+  if (--frame.type->depth == 0)
+    frame.type->totalBytes += bytes;
+  if (!stack.empty())
+    stack.back().childBytes += bytes;
+}
+
+void SaveStatistics::addFields(const std::type_info& type, const char* fields) {
+  auto& info = types[std::type_index(type)];
+  if (info.fields.empty())
+    info.fields = fields;
+}
+
+static std::string getTypeName(const std::type_index& type) {
+  std::string name = type.name();
+#ifdef __GNUC__
+  int status;
+  if (char* demangled = abi::__cxa_demangle(type.name(), nullptr, nullptr, &status)) {
+    name = demangled;
+    free(demangled);
+  }
+#endif
+  return name;
+}
+
+void SaveStatistics::printReport(ostream& out, int maxTypes) const {
+  std::vector<std::pair<std::type_index, const TypeInfo*>> sorted;
+  for (auto& elem : types)
+    // cereal's wrappers, like size tags and pointer wrappers, would only repeat the bytes of what they wrap
+    if (elem.second.count > 0 && getTypeName(elem.first).compare(0, 8, "cereal::") != 0)
+      sorted.push_back({elem.first, &elem.second});
+  std::sort(sorted.begin(), sorted.end(),
+      [](const auto& t1, const auto& t2) { return t1.second->selfBytes > t2.second->selfBytes; });
+  out << "Total: " << getTotalBytes() << " bytes\n";
+  out << "Self bytes, total bytes, objects, type\n";
+  for (int i = 0; i < std::min<int>(maxTypes, sorted.size()); ++i) {
+    auto& info = *sorted[i].second;
+    out << info.selfBytes << " (" << 100 * info.selfBytes / std::max(1LL, getTotalBytes()) << "%), " << info.totalBytes
+        << ", " << info.count << ", " << getTypeName(sorted[i].first) << "\n";
+  }
+}
+
+void SaveStatistics::printSchema(ostream& out) const {
+  std::vector<std::pair<string, string>> sorted;
+  for (auto& elem : types)
+    if (!elem.second.fields.empty())
+      sorted.push_back({getTypeName(elem.first), elem.second.fields});
+  std::sort(sorted.begin(), sorted.end());
+  for (auto& elem : sorted)
+    out << elem.first << ": " << elem.second << "\n";
+}
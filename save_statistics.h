@@ -0,0 +1,56 @@
+#pragma once
+
+#include <typeinfo>
+#include <typeindex>
+#include <string>
+#include <map>
+#include <vector>
+#include <ostream>
+#include <streambuf>
+
+// Bytes written to a binary archive per serialized type, gathered on the current thread while an instance
+// is alive. The archive has to write to getStream(), which only counts the bytes. The schema lists
+// the fields of classes that are serialized with the SERIALIZE_ALL and SERIALIZE_DEF macros.
+class SaveStatistics {
+  public:
+  SaveStatistics();
+  ~SaveStatistics();
+
+  std::ostream& getStream();
+  long long getTotalBytes() const;
+  void printReport(std::ostream&, int maxTypes) const;
+  void printSchema(std::ostream&) const;
+
+  // Called by the serialization code
+  static SaveStatistics* getCurrent();
+  void enter(const std::type_info&);
+  void exit();
+  void addFields(const std::type_info&, const char* fields);
+
+  private:
+  class CountingBuffer : public std::streambuf {
+    public:
+    long long count = 0;
+
+    protected:
+    std::streamsize xsputn(const char*, std::streamsize n) override;
+    int_type overflow(int_type c) override;
+  };
+  CountingBuffer buffer;
+  std::ostream stream;
+  struct TypeInfo {
+    long long count = 0;
+    long long selfBytes = 0;
+    long long totalBytes = 0;
+    int depth = 0;
+    std::string fields;
+  };
+  std::map<std::type_index, TypeInfo> types;
+  struct Frame {
+    TypeInfo* type;
+    long long start;
+    long long childBytes;
+  };
+  std::vector<Frame> stack;
+  SaveStatistics* previous;
+};
@@ -0,0 +1,109 @@
+#ifdef SAVE_TOOL
+#include "stdafx.h"
+#include "debug.h"
+#include "util.h"
+#include "parse_game.h"
+#include "game.h"
+#include "skill.h"
+#include "spell.h"
+#include "save_statistics.h"
+#define ProgramOptions_no_colors
+#include "extern/ProgramOptions.h"
+
+// Works on save files without the rest of the game: no window, sound or game data is needed.
+
+static PGame loadGame(const FilePath& path) {
+  PGame game;
+  CompressedInput input(path.getPath());
+  SaveFileHeader discard;
+  input.getArchive() >> discard.version >> discard.name >> discard.info;
+  input.getArchive() >> game;
+  return game;
+}
+
+static void validate(PGame& game) {
+  std::stringstream stream;
+  {
+    OutputArchive archive(stream);
+    Game::save(archive, game);
+  }
+  std::cout << "Saved again: " << stream.str().size() << " bytes uncompressed" << std::endl;
+  PGame loaded;
+  InputArchive archive(stream);
+  archive >> loaded;
+  std::cout << "Loaded again: " << loaded->getGameDisplayName() << std::endl;
+}
+
+static void printStatistics(PGame& game, int maxTypes, bool schema) {
+  // Separately compressed sites would be counted as strings, so they're all saved with the game
+  game->loadSavedSites();
+  SaveStatistics stats;
+  {
+    OutputArchive archive(stats.getStream());
+    Game::save(archive, game, false);
+  }
+  if (maxTypes > 0)
+    stats.printReport(std::cout, maxTypes);
+  if (schema)
+    stats.printSchema(std::cout);
+}
+
+static void convert(PGame& game, SaveFileHeader header, const FilePath& output) {
+  {
+    CompressedOutput out(output.getPath());
+    out.getArchive() << header.version << header.name << header.info;
+    Game::save(out.getArchive(), game);
+  }
+  writeSaveHeader(output, header);
+  std::cout << "Written " << output << " with version " << header.version << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+  po::parser flags;
+  flags["help"].description("Print help");
+  flags["input"].type(po::string).description("Path to a KeeperRL save file");
+  flags["validate"].description("Load the save, save it again and load the result");
+  flags["stats"].type(po::i32).description("Print bytes written per class, for the given number of largest classes");
+  flags["schema"].description("Print the serialized fields of each class found in the save");
+  flags["convert"].type(po::string).description("Save the game again to the given path with the current format");
+  flags["save_version"].type(po::i32).description("Save version to write when converting, by default the input's");
+  if (!flags.parseArgs(argc, argv))
+    return -1;
+  if (flags["help"].was_set() || !flags["input"].was_set()) {
+    std::cout << flags << endl;
+    return 0;
+  }
+  FilePath inputPath = FilePath::fromFullPath(flags["input"].get().string);
+  auto header = getSaveHeader(inputPath);
+  if (!header) {
+    std::cerr << "Can't read the header of " << inputPath << std::endl;
+    return 1;
+  }
+  std::cout << header->name << ", version " << header->version << std::endl;
+  Skill::init();
+  Spell::init();
+  PGame game;
+  try {
+    game = loadGame(inputPath);
+  } catch (std::exception& e) {
+    std::cerr << "Failed to load " << inputPath << ": " << e.what() << std::endl;
+    return 1;
+  }
+  std::cout << "Loaded " << game->getGameDisplayName() << std::endl;
+  try {
+    if (flags["validate"].was_set())
+      validate(game);
+    if (flags["stats"].was_set() || flags["schema"].was_set())
+      printStatistics(game, flags["stats"].was_set() ? flags["stats"].get().i32 : 0, flags["schema"].was_set());
+    if (flags["convert"].was_set()) {
+      if (flags["save_version"].was_set())
+        header->version = flags["save_version"].get().i32;
+      convert(game, *header, FilePath::fromFullPath(flags["convert"].get().string));
+    }
+  } catch (std::exception& e) {
+    std::cerr << "Failed: " << e.what() << std::endl;
+    return 1;
+  }
+}
+
+#endif
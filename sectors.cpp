@@ -16,6 +16,7 @@
 #include "stdafx.h"
 #include "sectors.h"
 #include "level.h"
+#include "memory_report.h"
 #include <limits>
 
 Sectors::Sectors(Rectangle b, ExtraConnections con) : bounds(b), sectors(bounds, -1), extraConnections(std::move(con)) {
@@ -88,10 +89,14 @@ void Sectors::join(Vec2 pos1, SectorId sector) {
   }
 }
 
-static DirtyTable<int> bfsTable(Level::getMaxBounds(), -1);
+// Separate for every thread and sized on demand, so that levels of any size can be searched
+static thread_local unique_ptr<DirtyTable<int>> bfsTablePtr;
 
 vector<Vec2> Sectors::getDisjoint(Vec2 pos) const {
   vector<queue<Vec2>> queues;
+  if (!bfsTablePtr || !bfsTablePtr->getBounds().contains(bounds))
+    bfsTablePtr = unique<DirtyTable<int>>(bounds, -1);
+  auto& bfsTable = *bfsTablePtr;
   bfsTable.clear();
   int numNeighbor = 0;
   for (Vec2 v : getNeighbors(pos))
@@ -191,3 +196,7 @@ void Sectors::dump() {
   }
   std::cout << endl;
 }
+
+long long Sectors::getMemoryUsage() const {
+  return MemoryReport::getSize(sectors) + MemoryReport::getSize(sizes) + MemoryReport::getSize(extraConnections);
+}
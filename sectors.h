@@ -32,9 +32,10 @@ class Sectors {
   void addExtraConnection(Vec2, Vec2);
   void removeExtraConnection(Vec2, Vec2);
   const ExtraConnections getExtraConnections() const;
+  long long getMemoryUsage() const;
 
   private:
-  using SectorId = short;
+  using SectorId = int;
   vector<Vec2> getNeighbors(Vec2) const;
   void setSector(Vec2, SectorId);
   SectorId getNewSector();
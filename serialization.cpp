@@ -36,6 +36,16 @@
 #include "view_index.h"
 #include "village_behaviour.h"
 
+static atomic<bool> bulkSerialization(true);
+
+void setBulkSerialization(bool state) {
+  bulkSerialization = state;
+}
+
+bool isBulkSerializationEnabled() {
+  return bulkSerialization;
+}
+
 REGISTER_TYPE(Player)
 REGISTER_TYPE(Monster)
 REGISTER_TYPE(PlayerControl)
@@ -38,6 +38,7 @@
 
 #include "stdafx.h"
 #include "progress.h"
+#include "save_statistics.h"
 
 typedef cereal::BinaryInputArchive InputArchive;
 typedef cereal::BinaryOutputArchive OutputArchive;
@@ -76,6 +77,7 @@ typedef cereal::BinaryOutputArchive OutputArchive;
 #define SERIALIZE_TMPL(CLASS, ...) \
 template <class Archive> \
 void CLASS::serialize(Archive& ar1, const unsigned int) { \
+  addSerialFields(ar1, this, #__VA_ARGS__);\
   ar1(__VA_ARGS__);\
 }
 
@@ -86,6 +88,7 @@ void CLASS::serialize(Archive& ar1, const unsigned int) { \
 #define SERIALIZE_ALL(...) \
   template <class Archive> \
   void serialize(Archive& ar1, const unsigned int) { \
+    addSerialFields(ar1, this, #__VA_ARGS__); \
     ar1(__VA_ARGS__); \
   }
 
@@ -137,4 +140,99 @@ void load(Archive& ar1, optional<T>& elem) {
   } else
     elem = none;
   }
+
+// Attributes the bytes written by a binary archive to the serialized classes, while SaveStatistics are gathered
+template <class T>
+void prologue(BinaryOutputArchive&, const T&) {
+  if (std::is_class<T>::value)
+    if (auto stats = SaveStatistics::getCurrent())
+      stats->enter(typeid(T));
+}
+
+template <class T>
+void epilogue(BinaryOutputArchive&, const T&) {
+  if (std::is_class<T>::value)
+    if (auto stats = SaveStatistics::getCurrent())
+      stats->exit();
+}
 } // namespace cereal
+
+// Records the field names passed to SERIALIZE_ALL and SERIALIZE_DEF in the schema of SaveStatistics
+template <class Archive, class T>
+void addSerialFields(Archive&, const T*, const char*) {
+}
+
+template <class T>
+void addSerialFields(OutputArchive&, const T*, const char* fields) {
+  if (auto stats = SaveStatistics::getCurrent())
+    stats->addFields(typeid(T), fields);
+}
+
+// Arrays of trivially copyable values are written to binary archives as one block of memory, after a tag
+// that tells how they were written. Text archives get the values one by one, without the tag.
+// Pointers are excluded, because they are serialized through cereal's object tracking.
+template <class Archive, class T>
+struct IsBulkSerializable : std::integral_constant<bool, std::is_trivially_copyable<T>::value && !std::is_pointer<T>::value &&
+    (std::is_same<Archive, InputArchive>::value || std::is_same<Archive, OutputArchive>::value)> {};
+
+// Can be turned off to measure the difference, loading understands both formats
+void setBulkSerialization(bool);
+bool isBulkSerializationEnabled();
+
+namespace bulk_serialization {
+enum Format : std::uint8_t { ELEMENTS = 0, LITTLE_ENDIAN_BLOCK = 1, BIG_ENDIAN_BLOCK = 2 };
+
+inline Format getNativeFormat() {
+  const std::uint16_t one = 1;
+  return *reinterpret_cast<const std::uint8_t*>(&one) == 1 ? LITTLE_ENDIAN_BLOCK : BIG_ENDIAN_BLOCK;
+}
+
+template <class Archive, class T>
+void saveArray(Archive& ar, const T* elems, int count, std::false_type) {
+  for (int i = 0; i < count; ++i)
+    ar << elems[i];
+}
+
+template <class Archive, class T>
+void saveArray(Archive& ar, const T* elems, int count, std::true_type) {
+  if (!isBulkSerializationEnabled()) {
+    ar << std::uint8_t(ELEMENTS);
+    saveArray(ar, elems, count, std::false_type());
+  } else {
+    ar << std::uint8_t(getNativeFormat()) << std::uint32_t(sizeof(T));
+    ar(cereal::binary_data(const_cast<T*>(elems), sizeof(T) * count));
+  }
+}
+
+template <class Archive, class T>
+void loadArray(Archive& ar, T* elems, int count, std::false_type) {
+  for (int i = 0; i < count; ++i)
+    ar >> elems[i];
+}
+
+template <class Archive, class T>
+void loadArray(Archive& ar, T* elems, int count, std::true_type) {
+  std::uint8_t format;
+  ar >> format;
+  if (format == ELEMENTS) {
+    loadArray(ar, elems, count, std::false_type());
+    return;
+  }
+  std::uint32_t elemSize;
+  ar >> elemSize;
+  // The block is a copy of memory, so it can only be read on a platform with the same layout
+  if (format != getNativeFormat() || elemSize != sizeof(T))
+    throw cereal::Exception("Array was saved on an incompatible platform");
+  ar(cereal::binary_data(elems, sizeof(T) * count));
+}
+}
+
+template <class Archive, class T>
+void saveArray(Archive& ar, const T* elems, int count) {
+  bulk_serialization::saveArray(ar, elems, count, IsBulkSerializable<Archive, T>());
+}
+
+template <class Archive, class T>
+void loadArray(Archive& ar, T* elems, int count) {
+  bulk_serialization::loadArray(ar, elems, count, IsBulkSerializable<Archive, T>());
+}
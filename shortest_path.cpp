@@ -34,6 +34,10 @@ class DistanceTable {
   public:
   DistanceTable(Rectangle bounds) : ddist(bounds), dirty(bounds, 0) {} 
 
+  const Rectangle& getBounds() const {
+    return ddist.getBounds();
+  }
+
   double getDistance(Vec2 v) const {
     PROFILE;
     return dirty[v] < counter ? ShortestPath::infinity : ddist[v];
@@ -54,16 +58,29 @@ class DistanceTable {
   int counter = 1;
 };
 
-static DistanceTable distanceTable(Level::getMaxBounds());
-static DirtyTable<double> navigationCostCache(Level::getMaxBounds(), 0);
+// Scratch tables are separate for every thread and grow to cover the largest area searched so far
+static thread_local unique_ptr<DistanceTable> distanceTable;
+static thread_local unique_ptr<DirtyTable<double>> navigationCostCache;
+
+static void prepareScratchTables(Rectangle area) {
+  if (!distanceTable || !distanceTable->getBounds().contains(area)) {
+    if (distanceTable) {
+      auto& old = distanceTable->getBounds();
+      area = Rectangle(min(old.left(), area.left()), min(old.top(), area.top()),
+          max(old.right(), area.right()), max(old.bottom(), area.bottom()));
+    }
+    distanceTable = unique<DistanceTable>(area);
+    navigationCostCache = unique<DirtyTable<double>>(area, 0);
+  }
+}
 
 static function<double(Vec2)> getCached(function<double(Vec2)> fun) {
   return [fun] (Vec2 v) {
-    if (navigationCostCache.isDirty(v))
-      return navigationCostCache.getDirtyValue(v);
+    if (navigationCostCache->isDirty(v))
+      return navigationCostCache->getDirtyValue(v);
     else {
       auto res = fun(v);
-      navigationCostCache.setValue(v, res);
+      navigationCostCache->setValue(v, res);
       return res;
     }
   };
@@ -74,14 +91,14 @@ const int margin = 15;
 ShortestPath::ShortestPath(Rectangle a, function<double(Vec2)> entryFun, function<double(Vec2, Vec2)> lengthFun,
     function<vector<Vec2>(Vec2)> directions, Vec2 to, Vec2 from, double mult) : target(to), bounds(a) {
   PROFILE;
-  CHECK(Level::getMaxBounds().contains(a));
-  navigationCostCache.clear();
+  prepareScratchTables(a);
+  navigationCostCache->clear();
   if (mult == 0)
     init(getCached(entryFun), lengthFun, directions, target, from);
   else {
     init(getCached(entryFun), lengthFun, directions, target, none, revShortestLimit);
-    distanceTable.setDistance(target, infinity);
-    navigationCostCache.clear();
+    distanceTable->setDistance(target, infinity);
+    navigationCostCache->clear();
     reverse(getCached(entryFun), lengthFun, directions, mult, from, revShortestLimit);
   }
 }
@@ -105,24 +122,24 @@ void ShortestPath::init(function<double(Vec2)> entryFun, function<double(Vec2, V
     optional<Vec2> from, optional<int> limit) {
   PROFILE;
   reversed = false;
-  distanceTable.clear();
+  distanceTable->clear();
   function<QueueElem(Vec2)> makeElem;
   if (from)
-    makeElem = [&](Vec2 pos) ->QueueElem { return {pos, distanceTable.getDistance(pos) + lengthFun(*from, pos)}; };
+    makeElem = [&](Vec2 pos) ->QueueElem { return {pos, distanceTable->getDistance(pos) + lengthFun(*from, pos)}; };
   else
-    makeElem = [&](Vec2 pos) ->QueueElem { return {pos, distanceTable.getDistance(pos)}; };
+    makeElem = [&](Vec2 pos) ->QueueElem { return {pos, distanceTable->getDistance(pos)}; };
   priority_queue<QueueElem, vector<QueueElem>> q;
-  distanceTable.setDistance(target, 0);
+  distanceTable->setDistance(target, 0);
   q.push(makeElem(target));
   int numPopped = 0;
   while (!q.empty()) {
     ++numPopped;
     Vec2 pos = q.top().pos;
-    double posDist = distanceTable.getDistance(pos);
+    double posDist = distanceTable->getDistance(pos);
    // INFO << "Popping " << pos << " " << distance[pos]  << " " << (from ? (*from - pos).length4() : 0);
-    if (from == pos || (limit && distanceTable.getDistance(pos) >= *limit)) {
+    if (from == pos || (limit && distanceTable->getDistance(pos) >= *limit)) {
       INFO << "Shortest path from " << (from ? *from : Vec2(-1, -1)) << " to " << target << " " << numPopped
-        << " visited distance " << distanceTable.getDistance(pos);
+        << " visited distance " << distanceTable->getDistance(pos);
       constructPath(pos, directions);
       return;
     }
@@ -132,12 +149,12 @@ void ShortestPath::init(function<double(Vec2)> entryFun, function<double(Vec2, V
       for (Vec2 dir : directions(pos)) {
         Vec2 next = pos + dir;
         if (next.inRectangle(bounds)) {
-          double nextDist = distanceTable.getDistance(next);
+          double nextDist = distanceTable->getDistance(next);
           if (posDist < nextDist) {
             double dist = posDist + entryFun(next);
             //CHECK(dist > cdist) << "Entry fun non positive " << dist - cdist;
             if (dist < nextDist) {
-              distanceTable.setDistance(next, dist);
+              distanceTable->setDistance(next, dist);
               q.push(makeElem(next));
             }
           }
@@ -152,13 +169,13 @@ void ShortestPath::reverse(function<double(Vec2)> entryFun, function<double(Vec2
     double mult, Vec2 from, int limit) {
   PROFILE;
   reversed = true;
-  function<QueueElem(Vec2)> makeElem = [&](Vec2 pos)->QueueElem { return {pos, distanceTable.getDistance(pos)
+  function<QueueElem(Vec2)> makeElem = [&](Vec2 pos)->QueueElem { return {pos, distanceTable->getDistance(pos)
       + lengthFun(from, pos)};};
   priority_queue<QueueElem, vector<QueueElem>> q;
   for (Vec2 v : bounds) {
-    double dist = distanceTable.getDistance(v);
+    double dist = distanceTable->getDistance(v);
     if (dist <= limit) {
-      distanceTable.setDistance(v, mult * dist);
+      distanceTable->setDistance(v, mult * dist);
       q.push(makeElem(v));
     }
   }
@@ -174,9 +191,9 @@ void ShortestPath::reverse(function<double(Vec2)> entryFun, function<double(Vec2
     q.pop();
     for (Vec2 dir : directions(pos))
       if ((pos + dir).inRectangle(bounds)) {
-        if (distanceTable.getDistance(pos + dir) > distanceTable.getDistance(pos) + entryFun(pos + dir) && 
-            distanceTable.getDistance(pos + dir) < 0) {
-          distanceTable.setDistance(pos + dir, distanceTable.getDistance(pos) + entryFun(pos + dir));
+        if (distanceTable->getDistance(pos + dir) > distanceTable->getDistance(pos) + entryFun(pos + dir) && 
+            distanceTable->getDistance(pos + dir) < 0) {
+          distanceTable->setDistance(pos + dir, distanceTable->getDistance(pos) + entryFun(pos + dir));
           q.push(makeElem(pos + dir));
         }
       }
@@ -188,16 +205,16 @@ void ShortestPath::constructPath(Vec2 pos, function<vector<Vec2>(Vec2)> directio
   vector<Vec2> ret;
   while (pos != target) {
     Vec2 next;
-    double lowest = distanceTable.getDistance(pos);
+    double lowest = distanceTable->getDistance(pos);
     CHECK(lowest < infinity);
     for (Vec2 dir : directions(pos)) {
       double dist;
-      if ((pos + dir).inRectangle(bounds) && (dist = distanceTable.getDistance(pos + dir)) < lowest) {
+      if ((pos + dir).inRectangle(bounds) && (dist = distanceTable->getDistance(pos + dir)) < lowest) {
         lowest = dist;
         next = pos + dir;
       }
     }
-    if (lowest >= distanceTable.getDistance(pos)) {
+    if (lowest >= distanceTable->getDistance(pos)) {
       if (reversed)
         break;
       else
@@ -326,23 +343,24 @@ bool LevelShortestPath::isReversed() const {
 
 Dijkstra::Dijkstra(Rectangle bounds, vector<Vec2> from, int maxDist, function<double(Vec2)> entryFun,
       vector<Vec2> directions) {
-  distanceTable.clear();
+  prepareScratchTables(bounds);
+  distanceTable->clear();
   function<bool(Vec2, Vec2)> comparator = [](Vec2 pos1, Vec2 pos2) {
-      double diff = distanceTable.getDistance(pos1) - distanceTable.getDistance(pos2);
+      double diff = distanceTable->getDistance(pos1) - distanceTable->getDistance(pos2);
       if (diff > 0 || (diff == 0 && pos1 < pos2))
         return 1;
       else
         return 0;};
   priority_queue<Vec2, vector<Vec2>, decltype(comparator)> q(comparator) ;
   for (auto& v : from) {
-    distanceTable.setDistance(v, 0);
+    distanceTable->setDistance(v, 0);
     q.push(v);
   }
   int numPopped = 0;
   while (!q.empty()) {
     ++numPopped;
     Vec2 pos = q.top();
-    double cdist = distanceTable.getDistance(pos);
+    double cdist = distanceTable->getDistance(pos);
     if (cdist > maxDist)
       return;
     q.pop();
@@ -351,12 +369,12 @@ Dijkstra::Dijkstra(Rectangle bounds, vector<Vec2> from, int maxDist, function<do
     for (Vec2 dir : directions) {
       Vec2 next = pos + dir;
       if (next.inRectangle(bounds)) {
-        double ndist = distanceTable.getDistance(next);
+        double ndist = distanceTable->getDistance(next);
         if (cdist < ndist) {
           double dist = cdist + entryFun(next);
           CHECK(dist > cdist) << "Entry fun non positive " << dist - cdist;
           if (dist < ndist && dist <= maxDist) {
-            distanceTable.setDistance(next, dist);
+            distanceTable->setDistance(next, dist);
             q.push(next);
           }
         }
@@ -379,9 +397,10 @@ const map<Vec2, double>& Dijkstra::getAllReachable() const {
 }
 
 BfSearch::BfSearch(Rectangle bounds, Vec2 from, function<bool(Vec2)> entryFun, vector<Vec2> directions) {
-  distanceTable.clear();
+  prepareScratchTables(bounds);
+  distanceTable->clear();
   queue<Vec2> q;
-  distanceTable.setDistance(from, 0);
+  distanceTable->setDistance(from, 0);
   q.push(from);
   int numPopped = 0;
   while (!q.empty()) {
@@ -392,8 +411,8 @@ BfSearch::BfSearch(Rectangle bounds, Vec2 from, function<bool(Vec2)> entryFun, v
     reachable.insert(pos);
     for (Vec2 dir : directions) {
       Vec2 next = pos + dir;
-      if (next.inRectangle(bounds) && distanceTable.getDistance(next) == ShortestPath::infinity && entryFun(next)) {
-        distanceTable.setDistance(next, 0);
+      if (next.inRectangle(bounds) && distanceTable->getDistance(next) == ShortestPath::infinity && entryFun(next)) {
+        distanceTable->setDistance(next, 0);
         q.push(next);
       }
     }
@@ -32,6 +32,8 @@ static int getTableNum(const FilePath& path) {
 }
 
 Table<char> SokobanInput::getNext() {
+  // Campaign sites may be generated in parallel
+  std::unique_lock<std::mutex> lock(mut);
   ifstream input(levelsPath.getPath());
   CHECK(input) << "Failed to load sokoban data from " << levelsPath;
   vector<Table<char>> rest;
@@ -13,4 +13,5 @@ class SokobanInput {
   private:
   FilePath levelsPath;
   FilePath statePath;
+  std::mutex mut;
 };
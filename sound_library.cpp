@@ -21,7 +21,7 @@ void SoundLibrary::playSound(const Sound& s) {
   if (volume < 0.0001)
     return;
   if (int numSounds = sounds[s.getId()].size()) {
-    int ind = Random.get(numSounds);
+    int ind = random.get(numSounds);
     audioDevice.play(sounds[s.getId()][ind], volume, s.getPitch());
   }
 }
@@ -19,4 +19,6 @@ class SoundLibrary {
   EnumMap<SoundId, vector<SoundBuffer>> sounds;
   double volume;
   AudioDevice& audioDevice;
+  // Not the game's Random, so that a replay doesn't depend on which sounds were played
+  RandomGen random;
 };
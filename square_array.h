@@ -2,6 +2,7 @@
 
 #include "util.h"
 #include "square.h"
+#include "memory_report.h"
 
 
 class SquareArray {
@@ -27,6 +28,13 @@ class SquareArray {
     return modified[pos].get();
   }
 
+  void reset(Vec2 pos) {
+    if (modified[pos]) {
+      modified[pos].clear();
+      --numModified;
+    }
+  }
+
   WConstSquare getReadonly(Vec2 pos) const {
     if (modified[pos])
       return modified[pos].get();
@@ -42,4 +50,8 @@ class SquareArray {
     return numModified;
   }
 
+  long long getMemoryUsage() const {
+    return MemoryReport::getSize(modified) + (long long) (numModified + 1) * sizeof(Square);
+  }
+
 };
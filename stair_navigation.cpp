@@ -0,0 +1,70 @@
+#include "stdafx.h"
+#include "stair_navigation.h"
+
+bool StairNavigation::update(const vector<vector<StairKey>>& levelStairs) {
+  unordered_map<StairKey, vector<int>> keyLevels;
+  for (int level : All(levelStairs))
+    for (auto& key : levelStairs[level])
+      keyLevels[key].push_back(level);
+  vector<vector<pair<int, StairKey>>> newGraph(levelStairs.size());
+  for (int level : All(levelStairs)) {
+    vector<char> connected(levelStairs.size(), false);
+    for (auto& key : levelStairs[level])
+      for (int other : keyLevels.at(key))
+        if (other != level && !connected[other]) {
+          connected[other] = true;
+          newGraph[level].emplace_back(other, key);
+        }
+  }
+  if (numLevels == levelStairs.size() && newGraph == graph)
+    return false;
+  numLevels = levelStairs.size();
+  graph = std::move(newGraph);
+  calculateRoutes();
+  return true;
+}
+
+void StairNavigation::calculateRoutes() {
+  nextStairs.clear();
+  nextStairs.resize(numLevels * numLevels);
+  vector<int> queue(numLevels);
+  for (int from : Range(numLevels)) {
+    // Breadth-first search, remembering the first stairs of the route to every level
+    auto route = [&](int to) -> optional<StairKey>& { return nextStairs[from * numLevels + to]; };
+    vector<char> visited(numLevels, false);
+    visited[from] = true;
+    int queueBegin = 0;
+    int queueEnd = 0;
+    for (auto& neighbor : graph[from]) {
+      visited[neighbor.first] = true;
+      route(neighbor.first) = neighbor.second;
+      queue[queueEnd++] = neighbor.first;
+    }
+    while (queueBegin < queueEnd) {
+      int level = queue[queueBegin++];
+      for (auto& neighbor : graph[level])
+        if (!visited[neighbor.first]) {
+          visited[neighbor.first] = true;
+          route(neighbor.first) = route(level);
+          queue[queueEnd++] = neighbor.first;
+        }
+    }
+  }
+}
+
+int StairNavigation::getNumLevels() const {
+  return numLevels;
+}
+
+optional<StairKey> StairNavigation::getNextStairs(int from, int to) const {
+  CHECK(from >= 0 && from < numLevels && to >= 0 && to < numLevels);
+  return nextStairs[from * numLevels + to];
+}
+
+optional<pair<int, int>> StairNavigation::getDisconnected() const {
+  for (int from : Range(numLevels))
+    for (int to : Range(numLevels))
+      if (from != to && !nextStairs[from * numLevels + to])
+        return make_pair(from, to);
+  return none;
+}
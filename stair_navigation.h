@@ -0,0 +1,26 @@
+#pragma once
+
+#include "util.h"
+#include "stair_key.h"
+
+// Graph of levels connected by shared stair keys. Stores for every pair of levels the stairs that
+// start the shortest route between them, in a flat table indexed by level numbers.
+class StairNavigation {
+  public:
+  // Every level is given as the list of its stair keys. Returns false if the graph didn't change,
+  // in which case the routes aren't recomputed.
+  bool update(const vector<vector<StairKey>>& levelStairs);
+
+  int getNumLevels() const;
+  optional<StairKey> getNextStairs(int from, int to) const;
+
+  // Returns a pair of levels that aren't connected, if there are any
+  optional<pair<int, int>> getDisconnected() const;
+
+  private:
+  void calculateRoutes();
+  int numLevels = 0;
+  // Neighbors of every level, with the first stair key that leads to them
+  vector<vector<pair<int, StairKey>>> graph;
+  vector<optional<StairKey>> nextStairs;
+};
@@ -0,0 +1,90 @@
+#include "stdafx.h"
+#include "startup_tasks.h"
+#include "thread_pool.h"
+#include "clock.h"
+
+StartupTasks::StartupTasks(ThreadPool& pool, bool print) : threadPool(pool), printTimesFlag(print) {
+}
+
+StartupTasks::TaskId StartupTasks::add(Task task, vector<TaskId> dependencies) {
+  TaskId id = tasks.size();
+  task.numUnfinishedDeps = dependencies.size();
+  for (auto dep : dependencies) {
+    CHECK(dep >= 0 && dep < id) << "Bad startup task dependency: " << task.name;
+    tasks[dep].dependents.push_back(id);
+  }
+  tasks.push_back(std::move(task));
+  return id;
+}
+
+StartupTasks::TaskId StartupTasks::addTask(const char* name, function<void()> fun, vector<TaskId> dependencies) {
+  return add(Task{name, std::move(fun), false}, std::move(dependencies));
+}
+
+StartupTasks::TaskId StartupTasks::addMainThreadTask(const char* name, function<void()> fun,
+    vector<TaskId> dependencies) {
+  return add(Task{name, std::move(fun), true}, std::move(dependencies));
+}
+
+void StartupTasks::execute(TaskId id) {
+  auto& task = tasks[id];
+  task.start = Clock::getRealMicros();
+  try {
+    task.fun();
+  } catch (...) {
+    std::unique_lock<std::mutex> lock(mut);
+    if (!exception)
+      exception = std::current_exception();
+    lock.unlock();
+    cond.notify_one();
+    return;
+  }
+  task.end = Clock::getRealMicros();
+  {
+    std::unique_lock<std::mutex> lock(mut);
+    ++numFinished;
+    for (auto dependent : task.dependents)
+      if (--tasks[dependent].numUnfinishedDeps == 0)
+        ready.push_back(dependent);
+  }
+  cond.notify_one();
+}
+
+void StartupTasks::run() {
+  auto start = Clock::getRealMicros();
+  for (auto id : All(tasks))
+    if (tasks[id].numUnfinishedDeps == 0)
+      ready.push_back(id);
+  std::unique_lock<std::mutex> lock(mut);
+  while (numFinished < tasks.size() && !exception) {
+    if (ready.empty()) {
+      cond.wait(lock);
+      continue;
+    }
+    auto current = ready;
+    ready.clear();
+    lock.unlock();
+    // Dispatch the worker tasks first so that they can run while the main thread is busy
+    for (auto id : current)
+      if (!tasks[id].mainThread)
+        threadPool.addTask([this, id] { execute(id); });
+    for (auto id : current)
+      if (tasks[id].mainThread)
+        execute(id);
+    lock.lock();
+  }
+  lock.unlock();
+  threadPool.wait();
+  if (exception)
+    std::rethrow_exception(exception);
+  if (printTimesFlag)
+    printTimes(start, Clock::getRealMicros());
+}
+
+void StartupTasks::printTimes(microseconds start, microseconds end) {
+  for (auto& task : tasks)
+    std::cout << task.name << (task.mainThread ? " (main thread)" : "") << ": started at "
+        << (task.start - start).count() / 1000 << "ms, took "
+        << (task.end - task.start).count() / 1000 << "ms" << std::endl;
+  std::cout << "Total startup time: " << (end - start).count() / 1000 << "ms" << std::endl;
+}
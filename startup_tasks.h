@@ -0,0 +1,41 @@
+#pragma once
+
+#include "util.h"
+
+class ThreadPool;
+
+// A dependency graph of the loading stages run at program start.
+// Stages that only decode data are run on the thread pool, while the ones that touch
+// the OpenGL context are always executed on the thread that calls run().
+class StartupTasks {
+  public:
+  StartupTasks(ThreadPool&, bool printTimes);
+
+  using TaskId = int;
+  TaskId addTask(const char* name, function<void()>, vector<TaskId> dependencies = {});
+  TaskId addMainThreadTask(const char* name, function<void()>, vector<TaskId> dependencies = {});
+
+  void run();
+
+  private:
+  struct Task {
+    const char* name;
+    function<void()> fun;
+    bool mainThread;
+    int numUnfinishedDeps;
+    vector<TaskId> dependents;
+    microseconds start;
+    microseconds end;
+  };
+  TaskId add(Task, vector<TaskId> dependencies);
+  void execute(TaskId);
+  void printTimes(microseconds start, microseconds end);
+  ThreadPool& threadPool;
+  bool printTimesFlag;
+  vector<Task> tasks;
+  std::mutex mut;
+  std::condition_variable cond;
+  vector<TaskId> ready;
+  int numFinished = 0;
+  std::exception_ptr exception;
+};
@@ -3,6 +3,7 @@
 #include "creature.h"
 #include "task.h"
 #include "creature_name.h"
+#include "memory_report.h"
 
 SERIALIZE_DEF(TaskMap, tasks, positionMap, reversePositions, taskByCreature, creatureByTask, marked, completionCost, priorityTasks, delayedTasks, highlight, taskById, taskByActivity, activityByTask);
 
@@ -249,3 +250,21 @@ const EntityMap<Task, CostInfo>& TaskMap::getCompletionCosts() const {
 WTask TaskMap::getTask(UniqueEntity<Task>::Id id) const {
   return taskById.getOrFail(id);
 }
+
+template <typename Key, typename Value>
+static long long getSize(const EntityMap<Key, Value>& m) {
+  return MemoryReport::getTreeSize<pair<const typename EntityMap<Key, Value>::EntityId, Value>>(m.getSize());
+}
+
+long long TaskMap::getMemoryUsage() const {
+  long long ret = getSize(taskByCreature) + getSize(creatureByTask) + getSize(positionMap) + getSize(taskById) +
+      getSize(completionCost) + getSize(delayedTasks) + getSize(activityByTask) +
+      MemoryReport::getTreeSize<UniqueEntity<Task>::Id>(priorityTasks.getSize()) +
+      MemoryReport::getSize(reversePositions) + MemoryReport::getSize(marked) + MemoryReport::getSize(highlight) +
+      MemoryReport::getSize(tasks) + tasks.size() * sizeof(Task);
+  for (auto& elem : reversePositions)
+    ret += MemoryReport::getSize(elem.second);
+  for (auto activity : ENUM_ALL(MinionActivity))
+    ret += MemoryReport::getSize(taskByActivity[activity]);
+  return ret;
+}
@@ -40,6 +40,7 @@ class TaskMap {
   const EntityMap<Task, CostInfo>& getCompletionCosts() const;
   WTask getTask(UniqueEntity<Task>::Id) const;
   void clearFinishedTasks();
+  long long getMemoryUsage() const;
 
   SERIALIZATION_DECL(TaskMap);
 
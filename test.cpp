@@ -38,7 +38,10 @@
 #include "position_matching.h"
 #include "dungeon_level.h"
 #include "villain_type.h"
+#include "stair_navigation.h"
 #include "roof_support.h"
+#include "chunked_table.h"
+#include "game_event.h"
 
 class Test {
   public:
@@ -183,6 +186,21 @@ class Test {
     CHECK(!path.isReachable(Vec2(1, 0)));
   }
 
+  // Searches on a thread that hasn't run ShortestPath have to set up their own scratch tables, also when
+  // a smaller area was searched before
+  void testDijkstraOnNewThread() {
+    std::thread([] {
+      BfSearch small(Rectangle(5, 5), Vec2(0, 0), [](Vec2) { return true; });
+      CHECK(small.isReachable(Vec2(4, 4)));
+      Dijkstra dijkstra(Rectangle(40, 40), {Vec2(35, 35)}, 100, [](Vec2) { return 1; }, Vec2::directions4());
+      CHECK(dijkstra.isReachable(Vec2(0, 0)));
+      CHECK(dijkstra.getDist(Vec2(0, 0)) == 70);
+      BfSearch large(Rectangle(40, 40), Vec2(39, 39), [](Vec2 v) { return v.x != 20; });
+      CHECK(!large.isReachable(Vec2(0, 0)));
+      CHECK(large.isReachable(Vec2(21, 0)));
+    }).join();
+  }
+
   void testShortestPathReverse() {
     vector<vector<double> > table { { 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1}, { 1, 1, 1, ShortestPath::infinity, ShortestPath::infinity, 1, 1, 1, 1, 1, 1}, { 1, 1, 1, ShortestPath::infinity, ShortestPath::infinity, 1, 1, 1, 1, 1, 1}};
     ShortestPath path(Rectangle(11, 3),
@@ -358,6 +376,75 @@ class Test {
     CHECK(t2[39][49] == 39 * 49);
   }
 
+  void testChunkedTable() {
+    ChunkedTable<int> t(Rectangle(-5, 10, 100, 300), -1);
+    CHECK(t[Vec2(99, 299)] == -1);
+    CHECK(t.getNumAllocatedChunks() == 0);
+    t.getWritable(Vec2(-5, 10)) = 3;
+    t.getWritable(Vec2(99, 299)) = 4;
+    CHECK(t.getNumAllocatedChunks() == 2);
+    auto t2 = t;
+    t.getWritable(Vec2(-5, 10)) = 5;
+    CHECK(t2[Vec2(-5, 10)] == 3);
+    CHECK(t2[Vec2(99, 299)] == 4);
+    CHECK(t2[Vec2(-4, 10)] == -1);
+    CHECK(t[Vec2(-5, 10)] == 5);
+  }
+
+  void testStairNavigation() {
+    auto k01 = StairKey::getNew();
+    auto k12 = StairKey::getNew();
+    auto k23 = StairKey::getNew();
+    auto k03 = StairKey::getNew();
+    StairNavigation navigation;
+    CHECK(navigation.update({{k01}, {k01, k12}, {k12, k23}, {k23}}));
+    CHECK(navigation.getNextStairs(0, 3) == k01);
+    CHECK(navigation.getNextStairs(3, 0) == k23);
+    CHECK(navigation.getNextStairs(2, 1) == k12);
+    CHECK(!navigation.getDisconnected());
+    CHECK(!navigation.update({{k01}, {k01, k12}, {k12, k23}, {k23}}));
+    CHECK(navigation.update({{k01, k03}, {k01, k12}, {k12, k23}, {k23, k03}}));
+    CHECK(navigation.getNextStairs(0, 3) == k03);
+    CHECK(navigation.getNextStairs(1, 3) == k12);
+    CHECK(navigation.update({{k01}, {k01}, {k23}, {k23}}));
+    CHECK(!navigation.getNextStairs(1, 2));
+    CHECK(!!navigation.getDisconnected());
+  }
+
+  template <typename T>
+  T saveAndLoad(const T& elem) {
+    std::stringstream stream;
+    {
+      OutputArchive archive(stream);
+      archive << elem;
+    }
+    T ret;
+    InputArchive archive(stream);
+    archive >> ret;
+    return ret;
+  }
+
+  void testTableSerialization() {
+    Table<int> t(Rectangle(-3, 2, 7, 9));
+    for (Vec2 v : t.getBounds())
+      t[v] = v.x * 100 + v.y;
+    ChunkedTable<double> c(Rectangle(100, 50), 1.5);
+    c.getWritable(Vec2(70, 10)) = 3;
+    for (bool bulk : {true, false}) {
+      setBulkSerialization(bulk);
+      auto t2 = saveAndLoad(t);
+      CHECK(t2.getBounds() == t.getBounds());
+      for (Vec2 v : t.getBounds())
+        CHECK(t2[v] == t[v]);
+      auto c2 = saveAndLoad(c);
+      CHECK(c2.getNumAllocatedChunks() == 1);
+      CHECK(c2[Vec2(70, 10)] == 3);
+      CHECK(c2[Vec2(71, 10)] == 1.5);
+      CHECK(c2[Vec2(0, 0)] == 1.5);
+    }
+    setBulkSerialization(true);
+  }
+
   void testProjection() {
   /*  Vec2 proj = AllegroView::projectOnBorders(Rectangle(5, 5), Vec2(6, 0));
     CHECKEQ(proj, Vec2(4, 1));
@@ -929,6 +1016,22 @@ class Test {
     PLevel level = builder.build(model.get(), levelMaker.get(), 1234);
   };
 
+  // Saved copies of frozen sites are reused while their change count stays the same
+  void testEventInOtherModel() {
+    MatchingTest t1;
+    MatchingTest t2;
+    int count1 = t1.model->getChangeCount();
+    int count2 = t2.model->getChangeCount();
+    GameEvent event = EventInfo::VisibilityChanged{t1.get(5, 5)};
+    t1.model->addEvent(event);
+    t2.model->addEvent(event);
+    CHECK(t1.model->getChangeCount() != count1);
+    CHECK(t2.model->getChangeCount() == count2);
+    GameEvent global = EventInfo::WonGame{};
+    t2.model->addEvent(global);
+    CHECK(t2.model->getChangeCount() != count2);
+  }
+
   void testPositionMatching1() {
     MatchingTest t;
     auto pos1 = t.get(5, 5);
@@ -1088,6 +1191,7 @@ void testAll() {
   Test().testAStar();
   Test().testShortestPath2();
   Test().testShortestPathReverse();
+  Test().testDijkstraOnNewThread();
   Test().testRange();
   Test().testRange2();
   Test().testRange3();
@@ -1098,6 +1202,9 @@ void testAll() {
   Test().testVec2();
   Test().testConcat();
   Test().testTable();
+  Test().testChunkedTable();
+  Test().testStairNavigation();
+  Test().testTableSerialization();
   Test().testVec2();
   Test().testRectangle();
   Test().testRectangleDistance();
@@ -1133,6 +1240,7 @@ void testAll() {
   Test().testPositionMatching2();
   Test().testPositionMatching3();
   Test().testPositionMatching4();
+  Test().testEventInOtherModel();
   Test().testDungeonLevel();
   Test().testRoofSupport1();
   Test().testRoofSupport2();
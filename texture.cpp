@@ -127,6 +127,26 @@ optional<SDL::GLenum> Texture::loadFromMaybe(SDL::SDL_Surface* imageOrig) {
   return none;
 }
 
+optional<SDL::GLenum> Texture::loadRegionFromMaybe(SDL::SDL_Surface* image, Rectangle region) {
+  CHECK(texId && image->format->BytesPerPixel == 4 && realSize == Vec2(image->w, image->h));
+  CHECK(Rectangle(realSize).contains(region)) << region;
+  int mode = image->format->Rmask == 0x000000ff ? GL_RGBA : GL_BGRA;
+  SDL::glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+  SDL::glPixelStorei(GL_UNPACK_ROW_LENGTH, image->pitch / 4);
+  SDL::glPixelStorei(GL_UNPACK_SKIP_PIXELS, region.left());
+  SDL::glPixelStorei(GL_UNPACK_SKIP_ROWS, region.top());
+  SDL::glBindTexture(GL_TEXTURE_2D, *texId);
+  SDL::glTexSubImage2D(GL_TEXTURE_2D, 0, region.left(), region.top(), region.width(), region.height(), mode,
+      GL_UNSIGNED_BYTE, image->pixels);
+  SDL::glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+  SDL::glPixelStorei(GL_UNPACK_SKIP_PIXELS, 0);
+  SDL::glPixelStorei(GL_UNPACK_SKIP_ROWS, 0);
+  auto error = SDL::glGetError();
+  if (error != GL_NO_ERROR)
+    return error;
+  return none;
+}
+
 optional<Texture> Texture::loadMaybe(const FilePath& path) {
   if (SDL::SDL_Surface* image = SDL::IMG_Load(path.getPath())) {
     Texture ret;
@@ -35,6 +35,8 @@ class Texture {
 
   static optional<Texture> loadMaybe(const FilePath&);
   optional<SDL::GLenum> loadFromMaybe(SDL::SDL_Surface*);
+  // Uploads only the given part of a 32-bit surface. The surface must have the same size as the texture.
+  optional<SDL::GLenum> loadRegionFromMaybe(SDL::SDL_Surface*, Rectangle);
 
   Vec2 getSize() const {
     return size;
@@ -0,0 +1,94 @@
+#include "stdafx.h"
+#include "thread_pool.h"
+
+ThreadPool::ThreadPool(int numThreads) {
+#ifdef OSX // see thread comment in stdafx.h, tasks may be generating levels
+  thread::attributes attr;
+  attr.set_stack_size(4096 * 4000);
+  for (int i : Range(numThreads))
+    workers.emplace_back(attr, [this] { workerLoop(); });
+#else
+  for (int i : Range(numThreads))
+    workers.emplace_back([this] { workerLoop(); });
+#endif
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::unique_lock<std::mutex> lock(mut);
+    finishing = true;
+  }
+  taskCond.notify_all();
+  for (auto& t : workers)
+    t.join();
+}
+
+int ThreadPool::getDefaultNumThreads() {
+  return max<int>(1, thread::hardware_concurrency());
+}
+
+int ThreadPool::getNumThreads() const {
+  return workers.size();
+}
+
+void ThreadPool::runTask(function<void()>& task) {
+  try {
+    task();
+  } catch (...) {
+    std::unique_lock<std::mutex> lock(mut);
+    if (!exception)
+      exception = std::current_exception();
+  }
+}
+
+void ThreadPool::addTask(function<void()> task) {
+  if (workers.empty()) {
+    runTask(task);
+    return;
+  }
+  {
+    std::unique_lock<std::mutex> lock(mut);
+    tasks.push(std::move(task));
+    ++numUnfinished;
+  }
+  taskCond.notify_one();
+}
+
+void ThreadPool::workerLoop() {
+  while (1) {
+    function<void()> task;
+    {
+      std::unique_lock<std::mutex> lock(mut);
+      while (tasks.empty() && !finishing)
+        taskCond.wait(lock);
+      if (tasks.empty())
+        return;
+      task = std::move(tasks.front());
+      tasks.pop();
+    }
+    runTask(task);
+    {
+      std::unique_lock<std::mutex> lock(mut);
+      --numUnfinished;
+    }
+    doneCond.notify_all();
+  }
+}
+
+void ThreadPool::wait() {
+  std::unique_lock<std::mutex> lock(mut);
+  while (numUnfinished > 0)
+    doneCond.wait(lock);
+  if (exception) {
+    auto e = exception;
+    exception = nullptr;
+    lock.unlock();
+    std::rethrow_exception(e);
+  }
+}
+
+void ThreadPool::forEach(int count, function<void(int)> fun) {
+  for (int i : Range(count))
+    addTask([i, &fun] { fun(i); });
+  wait();
+}
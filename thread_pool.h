@@ -0,0 +1,36 @@
+#pragma once
+
+#include "util.h"
+
+// A fixed set of worker threads executing queued tasks.
+// With zero threads all tasks are run immediately on the calling thread,
+// which is what --single_thread expects.
+class ThreadPool {
+  public:
+  ThreadPool(int numThreads = getDefaultNumThreads());
+  ThreadPool(const ThreadPool&) = delete;
+  ~ThreadPool();
+
+  void addTask(function<void()>);
+
+  // Blocks until all queued tasks are finished. If any of them has thrown, the first exception is rethrown here.
+  void wait();
+
+  // Calls fun(i) for every i in [0, count) and waits for all calls to finish.
+  void forEach(int count, function<void(int)> fun);
+
+  int getNumThreads() const;
+  static int getDefaultNumThreads();
+
+  private:
+  void workerLoop();
+  void runTask(function<void()>&);
+  vector<thread> workers;
+  std::mutex mut;
+  std::condition_variable taskCond;
+  std::condition_variable doneCond;
+  queue<function<void()>> tasks;
+  int numUnfinished = 0;
+  bool finishing = false;
+  std::exception_ptr exception;
+};
@@ -40,6 +40,7 @@ enum class UserInputId {
     CHEAT_SPELLS,
     CHEAT_POTIONS,
     RELOAD_DATA,
+    MEMORY_REPORT,
     TUTORIAL_CONTINUE,
     TUTORIAL_GO_BACK,
 // real-time actions
@@ -19,6 +19,10 @@
 #include "position.h"
 #include <time.h>
 
+RandomGen::RandomGen(int seed) {
+  init(seed);
+}
+
 void RandomGen::init(int seed) {
   generator.seed(seed);
 }
@@ -109,7 +113,7 @@ float RandomGen::getFloatFast(float a, float b) {
   return a + (b - a) * float(v) * (1.0f / float(INT_MAX - 1));
 }
 
-RandomGen Random;
+thread_local RandomGen Random(std::random_device{}());
 
 template string toString<int>(const int&);
 template string toString<unsigned int>(const unsigned int&);
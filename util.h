@@ -644,7 +644,10 @@ std::string operator "" _s(const char* str, size_t);
 class RandomGen {
   public:
   RandomGen() {}
+  explicit RandomGen(int seed);
   RandomGen(RandomGen&) = delete;
+  // Copies the generator state, so that the copy continues the same sequence.
+  RandomGen& operator = (const RandomGen&) = default;
   void init(int seed);
   int get(int max);
   long long getLL();
@@ -806,7 +809,9 @@ class RandomGen {
   }
 };
 
-extern RandomGen Random;
+// Every thread has its own generator. The main thread seeds it at startup, other threads start with
+// an unpredictable seed unless they take over the state of the thread that started them.
+extern thread_local RandomGen Random;
 
 inline std::ostream& operator <<(std::ostream& d, Rectangle rect) {
   return d << "(" << rect.left() << "," << rect.top() << ") (" << rect.right() << "," << rect.bottom() << ")";
@@ -923,16 +928,14 @@ class Table {
   template <class Archive>
   void save(Archive& ar, const unsigned int version) const {
     ar << bounds;
-    for (Vec2 v : bounds)
-      ar << (*this)[v];
+    saveArray(ar, mem.get(), bounds.width() * bounds.height());
   }
 
   template <class Archive>
   void load(Archive& ar, const unsigned int version) {
     ar >> bounds;
     mem.reset(new T[bounds.width() * bounds.height()]);
-    for (Vec2 v : bounds)
-      ar >> (*this)[v];
+    loadArray(ar, mem.get(), bounds.width() * bounds.height());
   }
 
   SERIALIZATION_CONSTRUCTOR(Table);
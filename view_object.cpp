@@ -294,7 +294,7 @@ ViewLayer ViewObject::layer() const {
   return viewLayer;
 }
 
-static EnumSet<ViewId> creatureIds {
+static const EnumSet<ViewId> creatureIds {
   ViewId::PLAYER,
   ViewId::KEEPER1,
   ViewId::KEEPER2,
@@ -404,7 +404,7 @@ static EnumSet<ViewId> creatureIds {
   ViewId::BUSH,
 };
 
-static EnumSet<ViewId> itemIds {
+static const EnumSet<ViewId> itemIds {
   ViewId::BODY_PART,
   ViewId::BONE,
   ViewId::SPEAR,
@@ -635,6 +635,17 @@ static Rectangle getBugReportPos(Renderer& renderer) {
   return Rectangle(renderer.getSize() - Vec2(100, 23), renderer.getSize());
 }
 
+void WindowView::drawProfilerOverlay() {
+  const int lineHeight = 18;
+  auto lines = Profiler::getOverlayText(12);
+  Vec2 pos(10, 80);
+  renderer.drawFilledRectangle(Rectangle(pos, pos + Vec2(600, lineHeight * lines.size() + 10)), Color(0, 0, 0, 170));
+  for (auto& line : lines) {
+    renderer.drawText(Color::WHITE, pos + Vec2(5, 5), line, Renderer::NONE, 14);
+    pos.y += lineHeight;
+  }
+}
+
 void WindowView::refreshScreen(bool flipBuffer) {
   {
     if (zoomUI > -1) {
@@ -649,6 +660,8 @@ void WindowView::refreshScreen(bool flipBuffer) {
     }
     drawMap();
   }
+  if (Profiler::isEnabled())
+    drawProfilerOverlay();
   auto bugReportPos = getBugReportPos(renderer);
   renderer.drawFilledRectangle(bugReportPos, Color::TRANSPARENT, Color::RED);
   renderer.drawText(Color::RED, bugReportPos.middle() - Vec2(0, 2), "report bug", Renderer::CenterType::HOR_VER);
@@ -1313,6 +1326,12 @@ void WindowView::keyboardAction(const SDL_Keysym& key) {
       gui.loadImages();
       inputQueue.push(UserInputId::RELOAD_DATA);
       break;
+    case SDL::SDLK_F6:
+      inputQueue.push(UserInputId::MEMORY_REPORT);
+      break;
+    case SDL::SDLK_F5:
+      Profiler::setEnabled(!Profiler::isEnabled());
+      break;
     case SDL::SDLK_TAB:
       // TODO: put it under different shortcut?
       inputQueue.push(UserInputId::CHEAT_SPELLS);
@@ -123,6 +123,7 @@ class WindowView: public View {
   void rebuildGui();
   int lastGuiHash = 0;
   void drawMap();
+  void drawProfilerOverlay();
   void propagateEvent(const Event& event, vector<SGuiElem>);
   void keyboardAction(const SDL::SDL_Keysym&);
 